@@ -46,7 +46,10 @@ int build_assets(Nob_Cmd *cmd)
     return 0;
 }
 
-int build_game(Nob_Cmd *cmd)
+// Compiles `sources` into BUILD_FOLDER "obj/<prefix><name>.o" and links them into `output`
+// together with `libs` (NULL-terminated).
+int build_program(Nob_Cmd *cmd, const char *output, const char *obj_prefix,
+                  const char **sources, size_t src_count, const char **libs)
 {
     if (!nob_mkdir_if_not_exists(BUILD_FOLDER))
         return 1;
@@ -54,43 +57,13 @@ int build_game(Nob_Cmd *cmd)
     if (!nob_mkdir_if_not_exists(BUILD_FOLDER "obj/"))
         return 1;
 
-    const char *sources[] = {
-        SRC_FOLDER "main.c",
-        SRC_FOLDER "app/app.c",
-        SRC_FOLDER "core/arena.c",
-        SRC_FOLDER "core/mat.c",
-        SRC_FOLDER "platform/window.c",
-        SRC_FOLDER "platform/input.c",
-        SRC_FOLDER "platform/time.c",
-        SRC_FOLDER "renderer/renderer.c",
-        SRC_FOLDER "core/geom.c",
-        SRC_FOLDER "core/culling.c",
-        SRC_FOLDER "scene/teapot_renderer.c",
-        SRC_FOLDER "core/camera.c",
-        SRC_FOLDER "assets/pakloader.c",
-        SRC_FOLDER "assets/objloader.c",
-        SRC_FOLDER "ui/overlay.c",
-        SRC_FOLDER "assets/model.c",
-        SRC_FOLDER "scene/teapot_scene.c",
-        SRC_FOLDER "scene/scene.c",
-        SRC_FOLDER "scene/scene_factory.c",
-        SRC_FOLDER "assets/loader.c",
-        SRC_FOLDER "debug/profiler.c",
-        SRC_FOLDER "core/camera_input.c",
-        SRC_FOLDER "ui/overlay_helpers.c",
-        SRC_FOLDER "scene/game_scene.c",
-        SRC_FOLDER "scene/game_object.c",
-    };
-
-    size_t src_count = sizeof(sources) / sizeof(sources[0]);
-
     Nob_Procs procs = {0};
     Nob_Cmd objs = {0};
 
     for (size_t i = 0; i < src_count; ++i) {
         const char *src = sources[i];
         const char *base = nob_path_name(src); // e.g. "main.c"
-        char *obj = nob_temp_sprintf(BUILD_FOLDER "obj/%s.o", base);
+        char *obj = nob_temp_sprintf(BUILD_FOLDER "obj/%s%s.o", obj_prefix, base);
 
         nob_cmd_append(cmd,
             "cc", "-Wall", "-Wextra", "-std=c99", "-Isrc",
@@ -110,14 +83,15 @@ int build_game(Nob_Cmd *cmd)
     Nob_Cmd link = {0};
     nob_cmd_append(&link,
         "cc",
-        "-o", BUILD_FOLDER "engine",
+        "-o", output,
         "-O3", "-march=native", "-flto=auto");
 
     if (objs.count > 0) {
         nob_da_append_many(&link, objs.items, objs.count);
     }
 
-    nob_cmd_append(&link, "-lSDL2", "-lm");
+    for (const char **lib = libs; *lib; ++lib)
+        nob_da_append(&link, *lib);
 
     if (!nob_cmd_run(&link))
         return 1;
@@ -125,6 +99,113 @@ int build_game(Nob_Cmd *cmd)
     return 0;
 }
 
+int build_game(Nob_Cmd *cmd)
+{
+    const char *sources[] = {
+        SRC_FOLDER "main.c",
+        SRC_FOLDER "app/app.c",
+        SRC_FOLDER "core/arena.c",
+        SRC_FOLDER "core/memory.c",
+        SRC_FOLDER "core/mat.c",
+        SRC_FOLDER "platform/window.c",
+        SRC_FOLDER "platform/input.c",
+        SRC_FOLDER "platform/time.c",
+        SRC_FOLDER "renderer/renderer.c",
+        SRC_FOLDER "renderer/command_buffer.c",
+        SRC_FOLDER "renderer/frame_pipeline.c",
+        SRC_FOLDER "renderer/renderer_sdl.c",
+        SRC_FOLDER "core/job_system.c",
+        SRC_FOLDER "core/geom.c",
+        SRC_FOLDER "core/culling.c",
+        SRC_FOLDER "core/clip.c",
+        SRC_FOLDER "core/occlusion.c",
+        SRC_FOLDER "core/bvh.c",
+        SRC_FOLDER "scene/mesh.c",
+        SRC_FOLDER "scene/teapot_renderer.c",
+        SRC_FOLDER "core/camera.c",
+        SRC_FOLDER "assets/pakloader.c",
+        SRC_FOLDER "assets/objloader.c",
+        SRC_FOLDER "ui/overlay.c",
+        SRC_FOLDER "assets/model.c",
+        SRC_FOLDER "scene/teapot_scene.c",
+        SRC_FOLDER "scene/scene.c",
+        SRC_FOLDER "scene/scene_factory.c",
+        SRC_FOLDER "assets/loader.c",
+        SRC_FOLDER "debug/profiler.c",
+        SRC_FOLDER "core/camera_input.c",
+        SRC_FOLDER "ui/overlay_helpers.c",
+        SRC_FOLDER "scene/game_scene.c",
+        SRC_FOLDER "scene/ground_grid.c",
+        SRC_FOLDER "scene/game_object.c",
+    };
+    const char *libs[] = { "-lSDL2", "-lm", "-pthread", NULL };
+
+    return build_program(cmd, BUILD_FOLDER "engine", "",
+                         sources, sizeof(sources) / sizeof(sources[0]), libs);
+}
+
+// Same rasterizer with the memory-only backend: no window, no SDL2 at build or run time.
+int build_headless(Nob_Cmd *cmd)
+{
+    const char *sources[] = {
+        SRC_FOLDER "main_headless.c",
+        SRC_FOLDER "core/mat.c",
+        SRC_FOLDER "core/geom.c",
+        SRC_FOLDER "core/culling.c",
+        SRC_FOLDER "core/clip.c",
+        SRC_FOLDER "core/occlusion.c",
+        SRC_FOLDER "core/camera.c",
+        SRC_FOLDER "renderer/renderer.c",
+        SRC_FOLDER "renderer/command_buffer.c",
+        SRC_FOLDER "renderer/renderer_headless.c",
+        SRC_FOLDER "core/job_system.c",
+        SRC_FOLDER "core/arena.c",
+        SRC_FOLDER "core/memory.c",
+        SRC_FOLDER "scene/mesh.c",
+        SRC_FOLDER "scene/teapot_renderer.c",
+        SRC_FOLDER "assets/pakloader.c",
+        SRC_FOLDER "assets/objloader.c",
+        SRC_FOLDER "assets/model.c",
+        SRC_FOLDER "assets/loader.c",
+    };
+    const char *libs[] = { "-lm", "-pthread", NULL };
+
+    // Separate object names: renderer.c etc. are shared with the game build.
+    return build_program(cmd, BUILD_FOLDER "headless", "headless_",
+                         sources, sizeof(sources) / sizeof(sources[0]), libs);
+}
+
+// Headless benchmark over fixed scenes and camera paths, see src/bench/bench.c.
+int build_bench(Nob_Cmd *cmd)
+{
+    const char *sources[] = {
+        SRC_FOLDER "bench/bench.c",
+        SRC_FOLDER "core/mat.c",
+        SRC_FOLDER "core/geom.c",
+        SRC_FOLDER "core/culling.c",
+        SRC_FOLDER "core/clip.c",
+        SRC_FOLDER "core/occlusion.c",
+        SRC_FOLDER "core/camera.c",
+        SRC_FOLDER "renderer/renderer.c",
+        SRC_FOLDER "renderer/command_buffer.c",
+        SRC_FOLDER "renderer/renderer_headless.c",
+        SRC_FOLDER "core/job_system.c",
+        SRC_FOLDER "core/arena.c",
+        SRC_FOLDER "core/memory.c",
+        SRC_FOLDER "scene/mesh.c",
+        SRC_FOLDER "scene/teapot_renderer.c",
+        SRC_FOLDER "scene/ground_grid.c",
+        SRC_FOLDER "assets/pakloader.c",
+        SRC_FOLDER "assets/objloader.c",
+        SRC_FOLDER "assets/model.c",
+        SRC_FOLDER "assets/loader.c",
+    };
+    const char *libs[] = { "-lm", "-pthread", NULL };
+
+    return build_program(cmd, BUILD_FOLDER "bench", "headless_",
+                         sources, sizeof(sources) / sizeof(sources[0]), libs);
+}
+
 int build_obj2c(Nob_Cmd *cmd)
 {
     nob_cmd_append(cmd,
@@ -149,6 +230,12 @@ int main(int argc, char **argv)
         if (strcmp(argv[1], "game") == 0)
             return build_game(&cmd);
 
+        if (strcmp(argv[1], "headless") == 0)
+            return build_headless(&cmd);
+
+        if (strcmp(argv[1], "bench") == 0)
+            return build_bench(&cmd);
+
         if (strcmp(argv[1], "obj2c") == 0)
             return build_obj2c(&cmd);
     }
@@ -10,7 +10,12 @@
 #include "core/mat.h"
 #include "core/vec.h"
 #include "ui/overlay.h"
+#include "renderer/frame_pipeline.h"
+#include "core/job_system.h"
+#include "core/arena.h"
+#include "core/memory.h"
 #include "core/culling.h"
+#include "core/clip.h"
 #include "scene/scene.h"
 #include "scene/scene_factory.h"
 #include "scene/teapot_scene.h"
@@ -29,11 +34,41 @@ typedef enum {
     APP_STATE_EXITING
 } AppState;
 
+// Per-frame storage for vertex data scenes build while recording, per pipeline packet.
+#define APP_COMMAND_ARENA_SIZE (1 << 20)
+// Initial size of each per-frame arena scenes allocate their update data from.
+#define APP_FRAME_ARENA_SIZE (256 * 1024)
+// Running frames allowed to warm up caches and grow buffers; after that any tracked heap
+// allocation is reported as a steady-state regression. Build with -DAPP_ALLOC_GUARD=
+// MEM_GUARD_ABORT to stop at the first one, or MEM_GUARD_OFF to disable the check.
+#define APP_ALLOC_GUARD_FRAMES 120
+#ifndef APP_ALLOC_GUARD
+#define APP_ALLOC_GUARD MEM_GUARD_WARN
+#endif
+// Colour/depth layout; build with -DAPP_RENDERER_LAYOUT=RENDERER_LAYOUT_TILED to try tiles.
+#ifndef APP_RENDERER_LAYOUT
+#define APP_RENDERER_LAYOUT RENDERER_LAYOUT_LINEAR
+#endif
+// Depth format; with RENDERER_DEPTH_REVERSED_F32 the projection and clip space follow the
+// renderer to reversed-Z.
+#ifndef APP_RENDERER_DEPTH
+#define APP_RENDERER_DEPTH RENDERER_DEPTH_F32
+#endif
+
 struct App {
     Window* window;
     Input input;
     Time time;
     Renderer* renderer;
+    FramePipeline* pipeline;
+    // Shared by the renderer, the scenes and asset loading. F2 toggles inline mode.
+    JobSystem* jobs;
+    int jobs_inline;
+    // Per-frame allocator, one per frame the pipeline can hold. Updates alternate between
+    // them and each is reset two frames later, once the frame that used it is presented.
+    Arena frame_arenas[2];
+    int frame_index;
+    int running_frames;
     Camera camera;
     int width;
     int height;
@@ -48,6 +83,10 @@ struct App {
     int loading_done;
     float loading_start_time;
     char loading_message[128];
+    // The model loads as a background job; its result message lands in load_result and is
+    // only read once the counter is done.
+    JobCounter loading;
+    char load_result[128];
     int third_person_mode;
 };
 
@@ -92,7 +131,8 @@ static void draw_cube(Renderer* renderer, Mat4 model, Mat4 view, Mat4 proj, int
         int clip_bad = 0;
         for (int j=0;j<3;j++) {
             world[j] = geom_transform_point(model, cube[tris[i][j]]);
-            if (!geom_project_point(view, proj, world[j], width, height, &screen[j], NULL)) { clip_bad = 1; break; }
+            if (!geom_project_point(view, proj, renderer_get_clip_depth(renderer), world[j], width, height,
+                                    &screen[j], NULL)) { clip_bad = 1; break; }
         }
         if (clip_bad) continue;
         if (geom_triangle_backface_cull(screen)) continue;
@@ -106,6 +146,21 @@ static void update_angle(float* angle) {
     if (*angle > 2.0f*3.14159265f) *angle -= 2.0f*3.14159265f;
 }
 
+static void load_model_job(void* ctx, int index) {
+    (void)index;
+    App* app = ctx;
+    char msg[128] = {0};
+    if (assets_load_model_from_pak("build/assets.pak", "monkey.obj",
+                                  &app->loaded_vertices, &app->loaded_faces,
+                                  &app->loaded_vertex_count, &app->loaded_face_count,
+                                  msg, sizeof(msg))) {
+        snprintf(app->load_result, sizeof(app->load_result), "Loaded %s", "monkey.obj");
+        normalize_model(app->loaded_vertices, app->loaded_vertex_count, 1.0f);
+    } else {
+        snprintf(app->load_result, sizeof(app->load_result), "%s", msg[0] ? msg : "Failed to load model");
+    }
+}
+
 static int text_pixel_width(const char* text, int scale) {
     if (!text) return 0;
     int len = (int)strlen(text);
@@ -122,8 +177,25 @@ App* app_create(int width, int height, const char* title) {
     app->window = window_create(width, height, title);
     if (!app->window) { free(app); return NULL; }
 
-    app->renderer = renderer_create(width, height, window_get_handle(app->window));
+    RendererConfig config = { APP_RENDERER_LAYOUT, APP_RENDERER_DEPTH };
+    app->renderer = renderer_create_ex(width, height, window_get_handle(app->window), &config);
     if (!app->renderer) { window_destroy(app->window); free(app); return NULL; }
+    app->jobs = job_system_create(SDL_GetCPUCount(), JOB_SYSTEM_PIN_THREADS);
+    if (!app->jobs) { renderer_destroy(app->renderer); window_destroy(app->window); free(app); return NULL; }
+    renderer_set_job_system(app->renderer, app->jobs);
+    renderer_set_present_mode(app->renderer, RENDERER_PRESENT_DIRECT);
+
+    app->pipeline = frame_pipeline_create(app->renderer, APP_COMMAND_ARENA_SIZE);
+    if (!app->pipeline) {
+        renderer_destroy(app->renderer);
+        job_system_destroy(app->jobs);
+        window_destroy(app->window);
+        free(app);
+        return NULL;
+    }
+
+    arena_init(&app->frame_arenas[0], APP_FRAME_ARENA_SIZE);
+    arena_init(&app->frame_arenas[1], APP_FRAME_ARENA_SIZE);
 
     time_init(&app->time);
     memset(&app->input, 0, sizeof(Input));
@@ -148,21 +220,31 @@ App* app_create(int width, int height, const char* title) {
         app->loading_message[0] = '\0';
 
     profiler_init();
+    profiler_set_job_system(app->jobs);
     return app;
 }
 
 void app_destroy(App* app) {
     if (!app) return;
+    mem_guard_set(MEM_GUARD_OFF);
+    job_system_wait(app->jobs, &app->loading);
+    frame_pipeline_destroy(app->pipeline);
     renderer_destroy(app->renderer);
     window_destroy(app->window);
     scene_manager_destroy();
+    job_system_destroy(app->jobs);
+    arena_free(&app->frame_arenas[0]);
+    arena_free(&app->frame_arenas[1]);
     if (app->loaded_vertices || app->loaded_faces) obj_free_mesh(app->loaded_vertices, app->loaded_faces);
     free(app);
 }
 
 void app_run(App* app) {
     float angle = 0.0f;
-    Mat4 proj = mat4_perspective(3.14159265f/3.0f, (float)app->width/app->height, 0.1f, 100.0f);
+    ClipDepth depth = renderer_get_clip_depth(app->renderer);
+    Mat4 proj = depth == CLIP_DEPTH_REVERSED
+        ? mat4_perspective_reversed(3.14159265f/3.0f, (float)app->width/app->height, 0.1f, 100.0f)
+        : mat4_perspective(3.14159265f/3.0f, (float)app->width/app->height, 0.1f, 100.0f);
 
     uint64_t t_start = 0, t_end = 0;
     double freq = (double)SDL_GetPerformanceFrequency();
@@ -187,21 +269,13 @@ void app_run(App* app) {
                     overlay_draw_text(app->renderer, app->loading_message, x, app->height/2 - 8, 4, 0xFFFFFFFF);
                 }
                 renderer_present(app->renderer);
+                job_system_run(app->jobs, load_model_job, app, 1, 1, &app->loading);
                 input_end_frame(&app->input);
                 continue;
             }
 
-            if (!app->loading_done) {
-                char msg[128] = {0};
-                if (assets_load_model_from_pak("build/assets.pak", "monkey.obj",
-                                              &app->loaded_vertices, &app->loaded_faces,
-                                              &app->loaded_vertex_count, &app->loaded_face_count,
-                                              msg, sizeof(msg))) {
-                    snprintf(app->loading_message, sizeof(app->loading_message), "Loaded %s", "monkey.obj");
-                    normalize_model(app->loaded_vertices, app->loaded_vertex_count, 1.0f);
-                } else {
-                    snprintf(app->loading_message, sizeof(app->loading_message), "%s", msg[0] ? msg : "Failed to load model");
-                }
+            if (!app->loading_done && job_counter_done(&app->loading)) {
+                memcpy(app->loading_message, app->load_result, sizeof(app->loading_message));
                 app->loading_done = 1;
             }
 
@@ -209,14 +283,14 @@ void app_run(App* app) {
             overlay_draw_centered_message(app->renderer, app->loading_message, app->width, app->height, 4, 0xFFFFFFFF);
             renderer_present(app->renderer);
 
-            if ((app->time.total_seconds - app->loading_start_time) < 1.0f) {
+            if (!app->loading_done || (app->time.total_seconds - app->loading_start_time) < 1.0f) {
                 input_end_frame(&app->input);
                 continue;
             }
 
 
             if (app->loaded_vertices && app->loaded_faces) {
-                app->scene = scene_factory_create_game_scene(app->loaded_vertices, app->loaded_faces, app->loaded_vertex_count, app->loaded_face_count, app->width, app->height);
+                app->scene = scene_factory_create_game_scene(app->loaded_vertices, app->loaded_faces, app->loaded_vertex_count, app->loaded_face_count, app->width, app->height, app->jobs);
                 scene_manager_set(app->scene);
                 app->third_person_mode = 1;
             } else {
@@ -231,22 +305,40 @@ void app_run(App* app) {
             /* Always process camera input (mouse yaw/pitch). Camera movement via WASD
              * is ignored when camera distance > 0 (orbit/third-person). */
             handle_camera_input(app);
+            if (app->input.keyboard.pressed[SDL_SCANCODE_F2]) {
+                app->jobs_inline = !app->jobs_inline;
+                job_system_set_inline(app->jobs, app->jobs_inline);
+            }
 
-            scene_manager_update(app->time.delta_seconds, &app->input, &app->camera, proj);
+            // Simulate and record this frame while the raster thread works on the last one.
+            app->frame_index ^= 1;
+            Arena* frame = &app->frame_arenas[app->frame_index];
+            arena_reset(frame);
+            scene_manager_update(app->time.delta_seconds, &app->input, &app->camera, proj, depth, frame);
 
             t_start = SDL_GetPerformanceCounter();
-            renderer_clear(app->renderer, 0xFF000000);
-            scene_manager_render(app->renderer);
-            overlay_draw_fps(app->renderer, app->time.delta_seconds);
+            CommandBuffer* commands = frame_pipeline_begin(app->pipeline);
+            scene_manager_render(commands);
             t_end = SDL_GetPerformanceCounter();
             profiler_record_draw((double)(t_end - t_start) / freq);
 
+            // Collect the previous frame and present it here: window calls stay on this thread.
             t_start = SDL_GetPerformanceCounter();
-            renderer_present(app->renderer);
+            int collected = frame_pipeline_wait(app->pipeline);
             t_end = SDL_GetPerformanceCounter();
-            profiler_record_present((double)(t_end - t_start) / freq);
+            profiler_record_raster_wait((double)(t_end - t_start) / freq);
+            if (collected) {
+                overlay_draw_fps(app->renderer, app->time.delta_seconds);
+                t_start = SDL_GetPerformanceCounter();
+                renderer_present(app->renderer);
+                t_end = SDL_GetPerformanceCounter();
+                profiler_record_present((double)(t_end - t_start) / freq);
+            }
+            renderer_clear(app->renderer, 0xFF000000);
+            frame_pipeline_submit(app->pipeline);
 
             profiler_frame_end();
+            if (++app->running_frames == APP_ALLOC_GUARD_FRAMES) mem_guard_set(APP_ALLOC_GUARD);
         }
 
         if (app->state == APP_STATE_EXITING) {
@@ -266,4 +358,7 @@ void app_run(App* app) {
                 (present_time / frame_count) * 1000.0);
         }
     }
+    // The raster thread may still be executing the last submitted frame, which reads scene
+    // data and the frame arenas; finish it before the caller tears those down.
+    frame_pipeline_wait(app->pipeline);
 }
@@ -4,6 +4,7 @@
 #include "core/log.h"
 #include <string.h>
 #include <stdlib.h>
+#include "core/memory.h"
 
 int assets_load_model_from_pak(const char* pak_path, const char* asset_name,
                                Vec3** out_vertices, Face** out_faces,
@@ -43,7 +44,7 @@ int assets_load_model_from_pak(const char* pak_path, const char* asset_name,
         ok = 0;
     }
 
-    free(data);
+    mem_free(data);
     pak_close(&pak);
     return ok;
 }
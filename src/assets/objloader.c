@@ -3,6 +3,8 @@
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
+#include "core/arena.h"
+#include "core/memory.h"
 
 static int parse_face_index(const char* token, int vertex_count) {
     int idx = 0;
@@ -18,8 +20,15 @@ int obj_parse_from_memory(const uint8_t* data, size_t size,
                           Face** out_faces, size_t* out_face_count) {
     if (!data || size == 0 || !out_vertices || !out_vertex_count || !out_faces || !out_face_count) return 0;
 
-    char* buf = malloc(size + 1);
-    if (!buf) return 0;
+    // The text copy and face tokens are temporaries on this thread's scratch arena.
+    Arena* scratch = arena_thread_scratch();
+    if (!scratch) return 0;
+    ArenaMarker scope = arena_save(scratch);
+    char* buf = arena_alloc(scratch, size + 1);
+    if (!buf) {
+        arena_restore(scratch, scope);
+        return 0;
+    }
     memcpy(buf, data, size);
     buf[size] = '\0';
 
@@ -39,13 +48,14 @@ int obj_parse_from_memory(const uint8_t* data, size_t size,
             if (sscanf(line + 2, "%f %f %f", &x, &y, &z) == 3) {
                 if (verts_count + 1 > verts_cap) {
                     size_t nc = verts_cap ? verts_cap * 2 : 256;
-                    Vec3* nv = realloc(verts, nc * sizeof(Vec3));
+                    Vec3* nv = mem_realloc(verts, nc * sizeof(Vec3), MEM_TAG_ASSETS);
                     if (!nv) goto fail;
                     verts = nv; verts_cap = nc;
                 }
                 verts[verts_count++] = (Vec3){x, y, z};
             }
         } else if (line[0] == 'f' && line[1] == ' ') {
+            ArenaMarker line_scope = arena_save(scratch);
             const char* p = line + 2;
             char* toks[8];
             int n = 0;
@@ -55,7 +65,7 @@ int obj_parse_from_memory(const uint8_t* data, size_t size,
                 const char* start = p;
                 while (*p && !isspace((unsigned char)*p)) ++p;
                 int len = (int)(p - start);
-                char* tok = malloc(len + 1);
+                char* tok = arena_alloc(scratch, len + 1);
                 if (!tok) goto fail;
                 memcpy(tok, start, len);
                 tok[len] = '\0';
@@ -74,16 +84,16 @@ int obj_parse_from_memory(const uint8_t* data, size_t size,
                 if (valid) {
                     if (faces_count + 1 > faces_cap) {
                         size_t nc = faces_cap ? faces_cap * 2 : 512;
-                        Face* nf = realloc(faces, nc * sizeof(Face));
-                        if (!nf) goto fail_free_toks;
+                        Face* nf = mem_realloc(faces, nc * sizeof(Face), MEM_TAG_ASSETS);
+                        if (!nf) goto end_face;
                         faces = nf; faces_cap = nc;
                     }
                     faces[faces_count++] = (Face){v[0], v[1], v[2]};
                     if (n == 4) {
                         if (faces_count + 1 > faces_cap) {
                             size_t nc = faces_cap ? faces_cap * 2 : 512;
-                            Face* nf = realloc(faces, nc * sizeof(Face));
-                            if (!nf) goto fail_free_toks;
+                            Face* nf = mem_realloc(faces, nc * sizeof(Face), MEM_TAG_ASSETS);
+                            if (!nf) goto end_face;
                             faces = nf; faces_cap = nc;
                         }
                         faces[faces_count++] = (Face){v[0], v[2], v[3]};
@@ -91,13 +101,13 @@ int obj_parse_from_memory(const uint8_t* data, size_t size,
                 }
             }
 
-        fail_free_toks:
-            for (int i = 0; i < n; ++i) free(toks[i]);
+        end_face:
+            arena_restore(scratch, line_scope);
         }
         line = strtok(NULL, "\r\n");
     }
 
-    free(buf);
+    arena_restore(scratch, scope);
     *out_vertices = verts;
     *out_vertex_count = verts_count;
     *out_faces = faces;
@@ -105,13 +115,13 @@ int obj_parse_from_memory(const uint8_t* data, size_t size,
     return 1;
 
 fail:
-    free(buf);
-    if (verts) free(verts);
-    if (faces) free(faces);
+    arena_restore(scratch, scope);
+    if (verts) mem_free(verts);
+    if (faces) mem_free(faces);
     return 0;
 }
 
 void obj_free_mesh(Vec3* vertices, Face* faces) {
-    if (vertices) free(vertices);
-    if (faces) free(faces);
+    if (vertices) mem_free(vertices);
+    if (faces) mem_free(faces);
 }
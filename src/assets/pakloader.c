@@ -1,6 +1,7 @@
 #include "pakloader.h"
 #include <stdlib.h>
 #include <string.h>
+#include "core/memory.h"
 
 int pak_open(PakFile *pak, const char *filename) {
     pak->file = fopen(filename, "rb");
@@ -8,7 +9,7 @@ int pak_open(PakFile *pak, const char *filename) {
 
     if (fread(&pak->asset_count, sizeof(uint32_t), 1, pak->file) != 1) return 0;
 
-    pak->entries = malloc(sizeof(AssetEntry) * pak->asset_count);
+    pak->entries = mem_alloc(sizeof(AssetEntry) * pak->asset_count, MEM_TAG_ASSETS);
     if (!pak->entries) return 0;
 
     if (fread(pak->entries, sizeof(AssetEntry), pak->asset_count, pak->file) != pak->asset_count)
@@ -20,7 +21,7 @@ int pak_open(PakFile *pak, const char *filename) {
 void pak_close(PakFile *pak) {
     if (!pak) return;
     if (pak->file) fclose(pak->file);
-    if (pak->entries) free(pak->entries);
+    if (pak->entries) mem_free(pak->entries);
     pak->file = NULL;
     pak->entries = NULL;
     pak->asset_count = 0;
@@ -36,12 +37,12 @@ AssetEntry* pak_find(PakFile *pak, const char *name) {
 
 uint8_t* pak_read_asset(PakFile *pak, AssetEntry *entry) {
     if (!pak || !pak->file || !entry) return NULL;
-    uint8_t *data = malloc(entry->size);
+    uint8_t *data = mem_alloc(entry->size, MEM_TAG_ASSETS);
     if (!data) return NULL;
 
     fseek(pak->file, entry->offset, SEEK_SET);
     if (fread(data, 1, entry->size, pak->file) != entry->size) {
-        free(data);
+        mem_free(data);
         return NULL;
     }
 
@@ -0,0 +1,474 @@
+// Deterministic benchmark: renders fixed scenes along scripted camera paths with the
+// headless backend and reports frame-time statistics. Nothing depends on input or on the
+// wall clock except the timings themselves.
+//
+// usage: bench [--frames N] [--warmup N] [--threads N] [--scene NAME] [--pak PATH]
+//              [--layout linear|tiled] [--depth f32|reversed-f32|d16|d24|d32]
+//              [--csv PATH] [--json PATH] [--baseline PATH] [--threshold PERCENT]
+//
+// Exits 1 when a scene fails to run, a timed frame allocates from the heap or the occluded
+// scene culls nothing, 2 when the baseline comparison finds a regression.
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "renderer/renderer.h"
+#include "renderer/command_buffer.h"
+#include "scene/teapot_renderer.h"
+#include "scene/ground_grid.h"
+#include "scene/mesh.h"
+#include "assets/loader.h"
+#include "assets/model.h"
+#include "core/camera.h"
+#include "core/mat.h"
+#include "core/clip.h"
+#include "core/occlusion.h"
+#include "core/memory.h"
+
+#define BENCH_WIDTH  1280
+#define BENCH_HEIGHT 720
+// Holds the ground grid's per-frame vertex streams.
+#define BENCH_COMMAND_ARENA_SIZE (1 << 20)
+// Occluded scenes: the model is drawn at OCCLUDER_SCALE as the occluder, with
+// OCCLUDEE_HIDDEN smaller copies on the view ray behind it and two more beside it. Each copy
+// is tested against an occlusion buffer at 1/OCCLUSION_SCALE resolution before transform.
+#define OCCLUDER_SCALE 2.0f
+#define OCCLUDEE_SCALE 0.6f
+#define OCCLUDEE_HIDDEN 4
+#define OCCLUDEE_COUNT (OCCLUDEE_HIDDEN + 2)
+#define OCCLUSION_SCALE 4
+
+typedef enum {
+    STAGE_TRANSFORM,  // vertex transform and projection (teapot_renderer_update)
+    STAGE_DRAW,       // clear and draw submission; includes rasterization when single-threaded
+    STAGE_RASTER,     // binned rasterization at flush
+    STAGE_PRESENT,    // final resolve and hand-off to the backend
+    STAGE_COUNT
+} BenchStage;
+
+static const char* stage_names[STAGE_COUNT] = { "transform", "draw", "raster", "present" };
+
+// Indexed by RendererDepthFormat.
+static const char* depth_names[] = { "f32", "reversed-f32", "d16", "d24", "d32" };
+#define DEPTH_FORMAT_COUNT (sizeof(depth_names) / sizeof(depth_names[0]))
+
+typedef struct {
+    const char* name;
+    const char* model;  // asset in the pak
+    int ground;         // draw the game scene's ground grid under the model
+    int occluded;       // draw the model as an occluder with copies hidden behind it
+    float radius, height;
+    Vec3 target;
+} BenchScene;
+
+static const BenchScene scenes[] = {
+    { "monkey",   "monkey.obj", 0, 0, 3.0f, 0.5f, {0, 0, 0} },
+    { "teapot",   "teapot.obj", 0, 0, 3.0f, 0.5f, {0, 0, 0} },
+    { "cat",      "cat.obj",    0, 0, 3.0f, 0.5f, {0, 0, 0} },
+    { "ground",   "monkey.obj", 1, 0, 6.0f, 3.0f, {0, 0.5f, -4} },
+    { "occluded", "monkey.obj", 0, 1, 5.0f, 0.5f, {0, 0, 0} },
+};
+#define SCENE_COUNT (sizeof(scenes) / sizeof(scenes[0]))
+
+typedef struct {
+    double mean, p50, p95, p99;
+    double stage_mean[STAGE_COUNT];
+    uint32_t frame_hash;
+    size_t frame_allocs;  // tracked heap allocations during timed frames; should be 0
+    size_t occlusion_tested, occlusion_culled;  // boxes over all timed frames
+    int ran;
+} BenchResult;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of an ascending array.
+static double percentile(const double* sorted, int n, double p) {
+    int rank = (int)ceil(p / 100.0 * n);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+// Places copy k of an occluded scene. The hidden copies follow the camera so they stay on
+// its line of sight through the occluder; the last two sit beside the occluder in view.
+static Mat4 occludee_model(const BenchScene* sc, Vec3 camera_pos, int k) {
+    Vec3 dir = vec3_normalize(vec3_sub(sc->target, camera_pos));
+    Vec3 right = vec3_normalize(vec3_cross(dir, (Vec3){0, 1, 0}));
+    Vec3 at = k < OCCLUDEE_HIDDEN
+        ? vec3_add(sc->target, vec3_scale(dir, 2.5f + 1.5f * (float)k))
+        : vec3_add(vec3_add(sc->target, vec3_scale(dir, 2.0f)),
+                   vec3_scale(right, k == OCCLUDEE_HIDDEN ? -3.0f : 3.0f));
+    float s = OCCLUDEE_SCALE;
+    return mat4_mul(mat4_translation(at), mat4_scale((Vec3){s, s, s}));
+}
+
+static uint32_t hash_frame(const uint32_t* pixels, size_t count) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < count; ++i) {
+        h ^= pixels[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Renders `frames` timed frames (after `warmup` untimed ones) of one full camera orbit.
+// Per-frame times in ms go to `times` (frames * STAGE_COUNT). Timed frames run under the
+// steady-state allocation guard. Returns 0 if the scene could not be set up.
+static int run_scene(const BenchScene* sc, const char* pak, int frames, int warmup, int threads,
+                     const RendererConfig* config, double* times, BenchResult* out) {
+    Vec3* vertices = NULL;
+    Face* faces = NULL;
+    size_t vertex_count = 0, face_count = 0;
+    char msg[128] = {0};
+    if (!assets_load_model_from_pak(pak, sc->model, &vertices, &faces,
+                                    &vertex_count, &face_count, msg, sizeof(msg))) {
+        fprintf(stderr, "bench: %s: %s\n", sc->name, msg[0] ? msg : "failed to load model");
+        return 0;
+    }
+    normalize_model(vertices, vertex_count, 1.0f);
+
+    Renderer* r = renderer_create_ex(BENCH_WIDTH, BENCH_HEIGHT, NULL, config);
+    TeapotRenderer* mesh = teapot_renderer_create(vertices, faces, vertex_count, face_count);
+    CommandBuffer* commands = command_buffer_create(BENCH_COMMAND_ARENA_SIZE);
+    JobSystem* jobs = threads > 1 ? job_system_create(threads, 0) : NULL;
+    Mesh* occludee = sc->occluded ? mesh_create(vertices, faces, vertex_count, face_count) : NULL;
+    OcclusionBuffer* ob = sc->occluded ? occlusion_create(BENCH_WIDTH, BENCH_HEIGHT, OCCLUSION_SCALE) : NULL;
+    if (!r || !mesh || !commands || (threads > 1 && !jobs) || (sc->occluded && (!occludee || !ob))) {
+        fprintf(stderr, "bench: %s: out of memory\n", sc->name);
+        occlusion_destroy(ob);
+        mesh_destroy(occludee);
+        job_system_destroy(jobs);
+        command_buffer_destroy(commands);
+        teapot_renderer_destroy(mesh);
+        renderer_destroy(r);
+        obj_free_mesh(vertices, faces);
+        return 0;
+    }
+    renderer_set_job_system(r, jobs);
+    teapot_renderer_set_job_system(mesh, jobs);
+
+    // Reversed depth needs the reversed projection to match its clip convention.
+    ClipDepth depth = renderer_get_clip_depth(r);
+    Mat4 proj = depth == CLIP_DEPTH_REVERSED
+        ? mat4_perspective_reversed(3.14159265f/3.0f, (float)BENCH_WIDTH/BENCH_HEIGHT, 0.1f, 100.0f)
+        : mat4_perspective(3.14159265f/3.0f, (float)BENCH_WIDTH/BENCH_HEIGHT, 0.1f, 100.0f);
+    Mat4 model = sc->ground ? mat4_translation(sc->target) : mat4_identity();
+    if (sc->occluded)
+        model = mat4_mul(mat4_translation(sc->target),
+                         mat4_scale((Vec3){OCCLUDER_SCALE, OCCLUDER_SCALE, OCCLUDER_SCALE}));
+    // The copies' transformed streams, reset every frame.
+    MeshInstance occludees[OCCLUDEE_COUNT];
+    memset(occludees, 0, sizeof(occludees));
+    Arena occludee_arena = {0};
+    if (occludee) arena_init(&occludee_arena, mesh_instance_scratch_size(occludee) * OCCLUDEE_COUNT);
+    Camera cam = camera_create((Vec3){0, 0, 0}, sc->target, (Vec3){0, 1, 0}, 0.0f, 0.0f);
+
+    size_t allocs_before = 0;
+    for (int i = -warmup; i < frames; ++i) {
+        if (i == 0) {
+            allocs_before = mem_guard_violations();
+            mem_guard_set(MEM_GUARD_WARN);
+        }
+        int f = i < 0 ? i + warmup : i;
+        float angle = 6.2831853f * (float)f / (float)frames;
+        cam.position = (Vec3){
+            sc->target.x + sc->radius * sinf(angle),
+            sc->target.y + sc->height,
+            sc->target.z + sc->radius * cosf(angle)
+        };
+        cam.target = sc->target;
+        Mat4 view = camera_get_view(&cam);
+
+        double t[STAGE_COUNT + 1];
+        t[0] = now_seconds();
+        teapot_renderer_update(mesh, model, view, proj, depth, cam.position, BENCH_WIDTH, BENCH_HEIGHT, NULL);
+        if (sc->occluded) {
+            Mat4 view_proj = mat4_mul(proj, view);
+            occlusion_clear(ob, depth);
+            mesh_draw_occluder(occludee, model, view_proj, ob);
+            arena_reset(&occludee_arena);
+            for (int k = 0; k < OCCLUDEE_COUNT; ++k) {
+                Mat4 m = occludee_model(sc, cam.position, k);
+                Vec3 c;
+                float radius;
+                mesh_world_sphere(occludee, m, &c, &radius);
+                Vec3 mn = {c.x - radius, c.y - radius, c.z - radius};
+                Vec3 mx = {c.x + radius, c.y + radius, c.z + radius};
+                occludees[k].visible = occlusion_test_aabb(ob, view_proj, mn, mx) &&
+                    mesh_instance_update(&occludees[k], occludee, m, view, proj, depth, NULL, cam.position,
+                                         BENCH_WIDTH, BENCH_HEIGHT, &occludee_arena, jobs);
+            }
+            if (i >= 0) {
+                OcclusionStats stats = occlusion_stats(ob);
+                out->occlusion_tested += stats.tested;
+                out->occlusion_culled += stats.culled;
+            }
+        }
+        t[1] = now_seconds();
+        renderer_clear(r, 0xFF000000);
+        command_buffer_reset(commands);
+        if (sc->ground) ground_grid_record(commands, command_sort_key(0, 0.0f), view, proj, depth, BENCH_WIDTH,
+                                          BENCH_HEIGHT);
+        teapot_renderer_record(mesh, commands, command_sort_key(1, 0.0f), 0);
+        // Culled copies keep visible at 0, which makes their record a no-op.
+        for (int k = 0; k < OCCLUDEE_COUNT; ++k)
+            mesh_instance_record(&occludees[k], commands, command_sort_key(1, 0.0f), 0);
+        command_buffer_execute(commands, r);
+        t[2] = now_seconds();
+        renderer_flush_discard_depth(r);
+        t[3] = now_seconds();
+        if (i == frames - 1) out->frame_hash = hash_frame(renderer_get_framebuffer(r), (size_t)BENCH_WIDTH * BENCH_HEIGHT);
+        renderer_present(r);
+        t[4] = now_seconds();
+
+        if (i < 0) continue;
+        for (int s = 0; s < STAGE_COUNT; ++s)
+            times[i * STAGE_COUNT + s] = (t[s + 1] - t[s]) * 1000.0;
+    }
+    mem_guard_set(MEM_GUARD_OFF);
+    out->frame_allocs = mem_guard_violations() - allocs_before;
+
+    arena_free(&occludee_arena);
+    occlusion_destroy(ob);
+    mesh_destroy(occludee);
+    command_buffer_destroy(commands);
+    teapot_renderer_destroy(mesh);
+    renderer_destroy(r);
+    job_system_destroy(jobs);
+    obj_free_mesh(vertices, faces);
+    return 1;
+}
+
+static void summarize(const double* times, int frames, BenchResult* out) {
+    double* totals = malloc(sizeof(double) * frames);
+    memset(out->stage_mean, 0, sizeof(out->stage_mean));
+    out->mean = 0.0;
+    for (int i = 0; i < frames; ++i) {
+        double total = 0.0;
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            total += times[i * STAGE_COUNT + s];
+            out->stage_mean[s] += times[i * STAGE_COUNT + s] / frames;
+        }
+        if (totals) totals[i] = total;
+        out->mean += total / frames;
+    }
+    if (!totals) {
+        out->p50 = out->p95 = out->p99 = out->mean;
+        return;
+    }
+    qsort(totals, frames, sizeof(double), compare_double);
+    out->p50 = percentile(totals, frames, 50.0);
+    out->p95 = percentile(totals, frames, 95.0);
+    out->p99 = percentile(totals, frames, 99.0);
+    free(totals);
+}
+
+static int write_json(const char* path, int frames, int threads, const char* layout, const char* depth,
+                      const BenchResult* results) {
+    FILE* f = fopen(path, "w");
+    if (!f) return 0;
+    fprintf(f, "{\n  \"frames\": %d,\n  \"width\": %d,\n  \"height\": %d,\n  \"threads\": %d,\n  \"layout\": \"%s\",\n"
+               "  \"depth\": \"%s\",\n  \"scenes\": [",
+            frames, BENCH_WIDTH, BENCH_HEIGHT, threads, layout, depth);
+    int first = 1;
+    for (size_t i = 0; i < SCENE_COUNT; ++i) {
+        const BenchResult* br = &results[i];
+        if (!br->ran) continue;
+        fprintf(f, "%s\n    { \"name\": \"%s\", \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f",
+                first ? "" : ",", scenes[i].name, br->mean, br->p50, br->p95, br->p99);
+        for (int s = 0; s < STAGE_COUNT; ++s)
+            fprintf(f, ", \"%s_ms\": %.4f", stage_names[s], br->stage_mean[s]);
+        fprintf(f, ", \"occlusion_tested\": %zu, \"occlusion_culled\": %zu", br->occlusion_tested,
+                br->occlusion_culled);
+        fprintf(f, ", \"frame_allocs\": %zu, \"frame_hash\": \"%08x\" }", br->frame_allocs, br->frame_hash);
+        first = 0;
+    }
+    fprintf(f, "\n  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+static char* read_file(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* text = size >= 0 ? malloc((size_t)size + 1) : NULL;
+    if (text) {
+        size_t n = fread(text, 1, (size_t)size, f);
+        text[n] = '\0';
+    }
+    fclose(f);
+    return text;
+}
+
+// Finds `"key": <number>` inside the scene object `"name": "<scene>"` of a file written by
+// write_json. Returns 0 if the scene or key is missing.
+static int json_scene_number(const char* text, const char* scene, const char* key, double* out) {
+    char needle[96];
+    snprintf(needle, sizeof(needle), "\"name\": \"%s\"", scene);
+    const char* obj = strstr(text, needle);
+    if (!obj) return 0;
+    const char* end = strchr(obj, '}');
+    snprintf(needle, sizeof(needle), "\"%s\":", key);
+    const char* at = strstr(obj, needle);
+    if (!at || (end && at > end)) return 0;
+    *out = strtod(at + strlen(needle), NULL);
+    return 1;
+}
+
+// Flags scenes whose p50 or p95 grew by more than `threshold` percent. Returns the number
+// of regressions, or -1 if the baseline cannot be read.
+static int compare_baseline(const char* path, double threshold, const BenchResult* results) {
+    char* text = read_file(path);
+    if (!text) return -1;
+
+    int regressions = 0;
+    printf("\nbaseline %s (threshold %.1f%%)\n", path, threshold);
+    for (size_t i = 0; i < SCENE_COUNT; ++i) {
+        const BenchResult* br = &results[i];
+        double base_p50, base_p95;
+        if (!br->ran) continue;
+        if (!json_scene_number(text, scenes[i].name, "p50_ms", &base_p50) ||
+            !json_scene_number(text, scenes[i].name, "p95_ms", &base_p95)) {
+            printf("  %-8s not in baseline\n", scenes[i].name);
+            continue;
+        }
+        double d50 = base_p50 > 0.0 ? (br->p50 / base_p50 - 1.0) * 100.0 : 0.0;
+        double d95 = base_p95 > 0.0 ? (br->p95 / base_p95 - 1.0) * 100.0 : 0.0;
+        int regressed = d50 > threshold || d95 > threshold;
+        regressions += regressed;
+        printf("  %-8s p50 %8.3f -> %8.3f ms (%+6.1f%%)  p95 %8.3f -> %8.3f ms (%+6.1f%%)%s\n",
+               scenes[i].name, base_p50, br->p50, d50, base_p95, br->p95, d95,
+               regressed ? "  REGRESSION" : "");
+    }
+    free(text);
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    int frames = 300, warmup = 10, threads = 1;
+    double threshold = 10.0;
+    const char* only = NULL;
+    const char* pak = "build/assets.pak";
+    const char* csv_path = NULL;
+    const char* json_path = NULL;
+    const char* baseline_path = NULL;
+    const char* layout = "linear";
+    const char* depth = "f32";
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!val) { fprintf(stderr, "bench: missing value for %s\n", arg); return 1; }
+        if      (strcmp(arg, "--frames") == 0)    frames = atoi(val);
+        else if (strcmp(arg, "--warmup") == 0)    warmup = atoi(val);
+        else if (strcmp(arg, "--threads") == 0)   threads = atoi(val);
+        else if (strcmp(arg, "--scene") == 0)     only = val;
+        else if (strcmp(arg, "--pak") == 0)       pak = val;
+        else if (strcmp(arg, "--layout") == 0)    layout = val;
+        else if (strcmp(arg, "--depth") == 0)     depth = val;
+        else if (strcmp(arg, "--csv") == 0)       csv_path = val;
+        else if (strcmp(arg, "--json") == 0)      json_path = val;
+        else if (strcmp(arg, "--baseline") == 0)  baseline_path = val;
+        else if (strcmp(arg, "--threshold") == 0) threshold = atof(val);
+        else { fprintf(stderr, "bench: unknown option %s\n", arg); return 1; }
+        ++i;
+    }
+    if (frames < 1) frames = 1;
+    if (warmup < 0) warmup = 0;
+
+    RendererConfig config = { RENDERER_LAYOUT_LINEAR };
+    if (strcmp(layout, "tiled") == 0) config.layout = RENDERER_LAYOUT_TILED;
+    else if (strcmp(layout, "linear") != 0) { fprintf(stderr, "bench: unknown layout %s\n", layout); return 1; }
+    size_t d = 0;
+    while (d < DEPTH_FORMAT_COUNT && strcmp(depth, depth_names[d]) != 0) ++d;
+    if (d == DEPTH_FORMAT_COUNT) { fprintf(stderr, "bench: unknown depth format %s\n", depth); return 1; }
+    config.depth_format = (RendererDepthFormat)d;
+
+    double* times = malloc(sizeof(double) * frames * STAGE_COUNT);
+    if (!times) { fprintf(stderr, "bench: out of memory\n"); return 1; }
+
+    FILE* csv = NULL;
+    if (csv_path) {
+        csv = fopen(csv_path, "w");
+        if (!csv) { fprintf(stderr, "bench: cannot write %s\n", csv_path); free(times); return 1; }
+        fprintf(csv, "scene,frame,total_ms");
+        for (int s = 0; s < STAGE_COUNT; ++s) fprintf(csv, ",%s_ms", stage_names[s]);
+        fprintf(csv, "\n");
+    }
+
+    BenchResult results[SCENE_COUNT];
+    memset(results, 0, sizeof(results));
+    printf("%d frames at %dx%d, %d thread(s), %s layout, %s depth\n", frames, BENCH_WIDTH, BENCH_HEIGHT, threads,
+           layout, depth);
+    printf("%-8s %9s %9s %9s %9s  %9s %9s %9s %9s\n", "scene", "mean", "p50", "p95", "p99",
+           stage_names[0], stage_names[1], stage_names[2], stage_names[3]);
+
+    int failed = 0;
+    for (size_t i = 0; i < SCENE_COUNT; ++i) {
+        const BenchScene* sc = &scenes[i];
+        if (only && strcmp(only, sc->name) != 0) continue;
+        if (!run_scene(sc, pak, frames, warmup, threads, &config, times, &results[i])) {
+            failed = 1;
+            continue;
+        }
+        results[i].ran = 1;
+        summarize(times, frames, &results[i]);
+
+        const BenchResult* br = &results[i];
+        printf("%-8s %9.3f %9.3f %9.3f %9.3f  %9.3f %9.3f %9.3f %9.3f\n", sc->name,
+               br->mean, br->p50, br->p95, br->p99,
+               br->stage_mean[0], br->stage_mean[1], br->stage_mean[2], br->stage_mean[3]);
+        if (sc->occluded) {
+            printf("%-8s occlusion culled %.1f of %.1f boxes per frame\n", "",
+                   (double)br->occlusion_culled / frames, (double)br->occlusion_tested / frames);
+            if (br->occlusion_culled == 0) {
+                fprintf(stderr, "bench: %s: occlusion culled nothing\n", sc->name);
+                failed = 1;
+            }
+        }
+        if (br->frame_allocs) {
+            fprintf(stderr, "bench: %s: %zu heap allocation(s) during timed frames\n", sc->name, br->frame_allocs);
+            failed = 1;
+        }
+
+        if (csv) {
+            for (int f = 0; f < frames; ++f) {
+                double total = 0.0;
+                for (int s = 0; s < STAGE_COUNT; ++s) total += times[f * STAGE_COUNT + s];
+                fprintf(csv, "%s,%d,%.4f", sc->name, f, total);
+                for (int s = 0; s < STAGE_COUNT; ++s) fprintf(csv, ",%.4f", times[f * STAGE_COUNT + s]);
+                fprintf(csv, "\n");
+            }
+        }
+    }
+    free(times);
+    if (csv && fclose(csv) != 0) { fprintf(stderr, "bench: cannot write %s\n", csv_path); failed = 1; }
+
+    if (json_path && !write_json(json_path, frames, threads, layout, depth, results)) {
+        fprintf(stderr, "bench: cannot write %s\n", json_path);
+        failed = 1;
+    }
+
+    if (baseline_path) {
+        int regressions = compare_baseline(baseline_path, threshold, results);
+        if (regressions < 0) {
+            fprintf(stderr, "bench: cannot read baseline %s\n", baseline_path);
+            return 1;
+        }
+        if (regressions > 0) return 2;
+    }
+    return failed;
+}
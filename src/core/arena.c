@@ -1,7 +1,21 @@
 #include "arena.h"
 #include <stdlib.h>
 #include <string.h>
-#include <assert.h>
+#include <pthread.h>
+#include "core/memory.h"
+
+// Scratch arenas start here and grow like any other arena.
+#define THREAD_SCRATCH_SIZE (256 * 1024)
+
+struct ArenaBlock {
+    ArenaBlock* prev;
+    size_t size;
+    size_t used;
+};
+
+static uint8_t* block_data(ArenaBlock* b) {
+    return (uint8_t*)(b + 1);
+}
 
 static size_t align_forward(size_t ptr, size_t align) {
     size_t mod = ptr & (align - 1);
@@ -9,36 +23,69 @@ static size_t align_forward(size_t ptr, size_t align) {
     return ptr;
 }
 
+static ArenaBlock* block_create(size_t size) {
+    ArenaBlock* b = mem_alloc(sizeof(ArenaBlock) + size, MEM_TAG_ARENA);
+    if (!b) return NULL;
+    b->prev = NULL;
+    b->size = size;
+    b->used = 0;
+    return b;
+}
+
+static void free_chain(ArenaBlock* b) {
+    while (b) {
+        ArenaBlock* prev = b->prev;
+        mem_free(b);
+        b = prev;
+    }
+}
+
 void arena_init(Arena* arena, size_t size) {
-    arena->memory = (uint8_t*)malloc(size);
-    assert(arena->memory && "Arena allocation failed");
-    arena->size = size;
-    arena->used = 0;
+    arena->block_size = size ? size : 1;
+    arena->spare = NULL;
+    // A failed first block is not fatal: the first allocation tries again.
+    arena->block = block_create(arena->block_size);
 }
 
 void arena_free(Arena* arena) {
-    free(arena->memory);
-    arena->memory = NULL;
-    arena->size = 0;
-    arena->used = 0;
+    free_chain(arena->block);
+    free_chain(arena->spare);
+    arena->block = NULL;
+    arena->spare = NULL;
 }
 
 void* arena_alloc(Arena* arena, size_t size) {
     return arena_alloc_aligned(arena, size, 8);
 }
 
-void* arena_alloc_aligned(Arena* arena, size_t size, size_t alignment) {
-    size_t current = (size_t)(arena->memory + arena->used);
-    size_t aligned = align_forward(current, alignment);
-    size_t offset = aligned - (size_t)arena->memory;
+// Fits the request in `b` or returns NULL.
+static void* block_alloc(ArenaBlock* b, size_t size, size_t alignment) {
+    size_t base = (size_t)block_data(b);
+    size_t offset = align_forward(base + b->used, alignment) - base;
+    if (offset > b->size || size > b->size - offset) return NULL;
+    b->used = offset + size;
+    return block_data(b) + offset;
+}
 
-    if (offset + size > arena->size) {
-        assert(0 && "Arena out of memory");
-        return NULL;
+void* arena_alloc_aligned(Arena* arena, size_t size, size_t alignment) {
+    if (arena->block) {
+        void* p = block_alloc(arena->block, size, alignment);
+        if (p) return p;
     }
 
-    arena->used = offset + size;
-    return arena->memory + offset;
+    // Chain a new block that surely fits, preferring one released by arena_restore.
+    size_t need = size + alignment;
+    ArenaBlock* b = arena->spare;
+    if (b && b->size >= need) {
+        arena->spare = b->prev;
+    } else {
+        b = block_create(need > arena->block_size ? need : arena->block_size);
+        if (!b) return NULL;
+    }
+    b->used = 0;
+    b->prev = arena->block;
+    arena->block = b;
+    return block_alloc(b, size, alignment);
 }
 
 void* arena_alloc_zero(Arena* arena, size_t size) {
@@ -48,5 +95,63 @@ void* arena_alloc_zero(Arena* arena, size_t size) {
 }
 
 void arena_reset(Arena* arena) {
-    arena->used = 0;
+    if (arena->spare || (arena->block && arena->block->prev)) {
+        // Last round outgrew one block: replace the chain with a block that holds it all.
+        size_t total = arena_capacity(arena);
+        arena_free(arena);
+        arena->block = block_create(total);
+    }
+    if (arena->block) arena->block->used = 0;
+}
+
+ArenaMarker arena_save(const Arena* arena) {
+    ArenaMarker m = { arena->block, arena->block ? arena->block->used : 0 };
+    return m;
+}
+
+void arena_restore(Arena* arena, ArenaMarker marker) {
+    // Back to an empty arena: same as a reset, which also merges any overflow blocks.
+    if (!marker.block || (marker.block->prev == NULL && marker.used == 0)) {
+        arena_reset(arena);
+        return;
+    }
+    while (arena->block && arena->block != marker.block) {
+        ArenaBlock* b = arena->block;
+        arena->block = b->prev;
+        b->prev = arena->spare;
+        arena->spare = b;
+    }
+    if (arena->block) arena->block->used = marker.used;
+}
+
+size_t arena_capacity(const Arena* arena) {
+    size_t total = 0;
+    for (ArenaBlock* b = arena->block; b; b = b->prev) total += b->size;
+    for (ArenaBlock* b = arena->spare; b; b = b->prev) total += b->size;
+    return total;
+}
+
+static pthread_key_t scratch_key;
+static pthread_once_t scratch_once = PTHREAD_ONCE_INIT;
+
+static void scratch_destroy(void* p) {
+    Arena* arena = p;
+    arena_free(arena);
+    mem_free(arena);
+}
+
+static void scratch_key_create(void) {
+    pthread_key_create(&scratch_key, scratch_destroy);
+}
+
+Arena* arena_thread_scratch(void) {
+    pthread_once(&scratch_once, scratch_key_create);
+    Arena* arena = pthread_getspecific(scratch_key);
+    if (arena) return arena;
+
+    arena = mem_alloc(sizeof(Arena), MEM_TAG_ARENA);
+    if (!arena) return NULL;
+    arena_init(arena, THREAD_SCRATCH_SIZE);
+    pthread_setspecific(scratch_key, arena);
+    return arena;
 }
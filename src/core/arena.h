@@ -4,12 +4,26 @@
 #include <stddef.h>
 #include <stdint.h>
 
+typedef struct ArenaBlock ArenaBlock;
+
+// Bump allocator over a chain of blocks. When the current block is full another one of at
+// least block_size bytes is chained on, so allocations only fail when malloc does. Reset
+// rewinds everything; if the last round needed more than one block they are merged into a
+// single one, so a steady per-frame workload stops touching the heap after a frame or two.
 typedef struct {
-    uint8_t* memory;
-    size_t size;
-    size_t used;
+    ArenaBlock* block;  // newest block, NULL before the first allocation
+    ArenaBlock* spare;  // blocks released by arena_restore, reused before mallocing
+    size_t block_size;
 } Arena;
 
+// Position to rewind to: everything allocated after arena_save is released by
+// arena_restore, earlier allocations stay. Markers nest like scopes.
+typedef struct {
+    ArenaBlock* block;
+    size_t used;
+} ArenaMarker;
+
+// Reserves the first block of `size` bytes, also the minimum size of later blocks.
 void arena_init(Arena* arena, size_t size);
 void arena_free(Arena* arena);
 void* arena_alloc(Arena* arena, size_t size);
@@ -17,4 +31,16 @@ void* arena_alloc_aligned(Arena* arena, size_t size, size_t alignment);
 void* arena_alloc_zero(Arena* arena, size_t size);
 void arena_reset(Arena* arena);
 
+ArenaMarker arena_save(const Arena* arena);
+void arena_restore(Arena* arena, ArenaMarker marker);
+
+// Bytes reserved across all blocks, in use or not.
+size_t arena_capacity(const Arena* arena);
+
+// The calling thread's own scratch arena, created on first use and freed when the thread
+// exits. Meant for temporaries inside one function or job: bracket them with
+// arena_save/arena_restore rather than resetting it. Threads that do frame work call it
+// once when they start, so the creation itself never lands inside a frame.
+Arena* arena_thread_scratch(void);
+
 #endif
@@ -0,0 +1,392 @@
+#include "bvh.h"
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include "memory.h"
+
+#define BVH_NULL (-1)
+// Traversal stack depth. Rotations keep the height near 1.44 * log2(n), so this covers any
+// tree that fits in memory.
+#define BVH_STACK 128
+
+typedef struct {
+    Vec3 min, max;
+} Aabb;
+
+typedef struct {
+    Aabb box;       // fat box for leaves, union of children for internal nodes
+    Aabb tight;     // leaves only: the box last given to insert/move
+    int parent;     // doubles as the free-list link for unused nodes
+    int child1, child2;
+    int height;     // 0 for leaves, -1 for free nodes
+    uint32_t user;
+} BvhNode;
+
+struct Bvh {
+    BvhNode* nodes;
+    int capacity;
+    int free_list;
+    int root;
+    size_t leaf_count;
+};
+
+static Aabb aabb_union(Aabb a, Aabb b) {
+    return (Aabb){
+        { fminf(a.min.x, b.min.x), fminf(a.min.y, b.min.y), fminf(a.min.z, b.min.z) },
+        { fmaxf(a.max.x, b.max.x), fmaxf(a.max.y, b.max.y), fmaxf(a.max.z, b.max.z) }
+    };
+}
+
+static float aabb_area(Aabb a) {
+    float dx = a.max.x - a.min.x, dy = a.max.y - a.min.y, dz = a.max.z - a.min.z;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+static int aabb_contains(Aabb outer, Aabb inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z
+        && inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+}
+
+static int aabb_overlaps(Aabb a, Aabb b) {
+    return a.min.x <= b.max.x && b.min.x <= a.max.x
+        && a.min.y <= b.max.y && b.min.y <= a.max.y
+        && a.min.z <= b.max.z && b.min.z <= a.max.z;
+}
+
+static float aabb_distance2(Aabb a, Vec3 p) {
+    float dx = fmaxf(fmaxf(a.min.x - p.x, 0.0f), p.x - a.max.x);
+    float dy = fmaxf(fmaxf(a.min.y - p.y, 0.0f), p.y - a.max.y);
+    float dz = fmaxf(fmaxf(a.min.z - p.z, 0.0f), p.z - a.max.z);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Frustum test of a box: 0 outside, 1 intersecting, 2 fully inside.
+static int frustum_classify(const Frustum* f, Aabb a) {
+    int inside = 2;
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+        Vec4 p = f->planes[i];
+        float far_d  = p.x * (p.x >= 0.0f ? a.max.x : a.min.x) + p.y * (p.y >= 0.0f ? a.max.y : a.min.y)
+                     + p.z * (p.z >= 0.0f ? a.max.z : a.min.z) + p.w;
+        if (far_d < 0.0f) return 0;
+        float near_d = p.x * (p.x >= 0.0f ? a.min.x : a.max.x) + p.y * (p.y >= 0.0f ? a.min.y : a.max.y)
+                     + p.z * (p.z >= 0.0f ? a.min.z : a.max.z) + p.w;
+        if (near_d < 0.0f) inside = 1;
+    }
+    return inside;
+}
+
+Bvh* bvh_create(void) {
+    Bvh* bvh = mem_calloc(1, sizeof(Bvh), MEM_TAG_SCENE);
+    if (!bvh) return NULL;
+    bvh->free_list = BVH_NULL;
+    bvh->root = BVH_NULL;
+    return bvh;
+}
+
+void bvh_destroy(Bvh* bvh) {
+    if (!bvh) return;
+    mem_free(bvh->nodes);
+    mem_free(bvh);
+}
+
+static int alloc_node(Bvh* bvh) {
+    if (bvh->free_list == BVH_NULL) {
+        int nc = bvh->capacity ? bvh->capacity * 2 : 64;
+        BvhNode* nn = mem_realloc(bvh->nodes, (size_t)nc * sizeof(BvhNode), MEM_TAG_SCENE);
+        if (!nn) return BVH_NULL;
+        bvh->nodes = nn;
+        for (int i = bvh->capacity; i < nc; ++i) {
+            nn[i].parent = i + 1 < nc ? i + 1 : BVH_NULL;
+            nn[i].height = -1;
+        }
+        bvh->free_list = bvh->capacity;
+        bvh->capacity = nc;
+    }
+    int id = bvh->free_list;
+    BvhNode* n = &bvh->nodes[id];
+    bvh->free_list = n->parent;
+    n->parent = n->child1 = n->child2 = BVH_NULL;
+    n->height = 0;
+    n->user = 0;
+    return id;
+}
+
+static void free_node(Bvh* bvh, int id) {
+    bvh->nodes[id].parent = bvh->free_list;
+    bvh->nodes[id].height = -1;
+    bvh->free_list = id;
+}
+
+// Rotates the taller grandchild up when the children of `a` differ in height by more than
+// one. Returns the index of the subtree's new root.
+static int balance(Bvh* bvh, int ia) {
+    BvhNode* n = bvh->nodes;
+    BvhNode* a = &n[ia];
+    if (a->height < 2) return ia;
+
+    int ib = a->child1, ic = a->child2;
+    int diff = n[ic].height - n[ib].height;
+    if (diff >= -1 && diff <= 1) return ia;
+
+    // Promote the taller child `up` into a's place; `down` is a's other child.
+    int up = diff > 1 ? ic : ib;
+    int down = diff > 1 ? ib : ic;
+    BvhNode* u = &n[up];
+    int i1 = u->child1, i2 = u->child2;
+
+    u->child1 = ia;
+    u->parent = a->parent;
+    a->parent = up;
+    if (u->parent != BVH_NULL) {
+        if (n[u->parent].child1 == ia) n[u->parent].child1 = up;
+        else n[u->parent].child2 = up;
+    } else {
+        bvh->root = up;
+    }
+
+    // The taller grandchild stays under `up`; the shorter one moves down to `a`.
+    int keep = n[i1].height > n[i2].height ? i1 : i2;
+    int move = keep == i1 ? i2 : i1;
+    u->child2 = keep;
+    if (diff > 1) a->child2 = move;
+    else a->child1 = move;
+    n[move].parent = ia;
+
+    a->box = aabb_union(n[down].box, n[move].box);
+    u->box = aabb_union(a->box, n[keep].box);
+    a->height = 1 + (n[down].height > n[move].height ? n[down].height : n[move].height);
+    u->height = 1 + (a->height > n[keep].height ? a->height : n[keep].height);
+    return up;
+}
+
+// Walks from `index` to the root, refitting boxes and heights and rebalancing.
+static void refit_upwards(Bvh* bvh, int index) {
+    while (index != BVH_NULL) {
+        index = balance(bvh, index);
+        BvhNode* n = &bvh->nodes[index];
+        BvhNode* c1 = &bvh->nodes[n->child1];
+        BvhNode* c2 = &bvh->nodes[n->child2];
+        n->height = 1 + (c1->height > c2->height ? c1->height : c2->height);
+        n->box = aabb_union(c1->box, c2->box);
+        index = n->parent;
+    }
+}
+
+static int insert_leaf(Bvh* bvh, int leaf) {
+    BvhNode* n = bvh->nodes;
+    if (bvh->root == BVH_NULL) {
+        bvh->root = leaf;
+        n[leaf].parent = BVH_NULL;
+        return 1;
+    }
+
+    // Descend towards the sibling that grows the total surface area the least.
+    Aabb box = n[leaf].box;
+    int index = bvh->root;
+    while (n[index].height > 0) {
+        float area = aabb_area(n[index].box);
+        float combined = aabb_area(aabb_union(n[index].box, box));
+        float cost = 2.0f * combined;             // pair the leaf with this whole subtree
+        float inherit = 2.0f * (combined - area); // growth pushed onto every ancestor below
+
+        float child_cost[2];
+        for (int k = 0; k < 2; ++k) {
+            int c = k == 0 ? n[index].child1 : n[index].child2;
+            float grown = aabb_area(aabb_union(n[c].box, box));
+            child_cost[k] = (n[c].height == 0 ? grown : grown - aabb_area(n[c].box)) + inherit;
+        }
+        if (cost < child_cost[0] && cost < child_cost[1]) break;
+        index = child_cost[0] < child_cost[1] ? n[index].child1 : n[index].child2;
+    }
+
+    int sibling = index;
+    int parent = alloc_node(bvh);
+    if (parent == BVH_NULL) return 0;
+    n = bvh->nodes;  // alloc_node may have moved the array
+
+    int old_parent = n[sibling].parent;
+    n[parent].parent = old_parent;
+    n[parent].box = aabb_union(box, n[sibling].box);
+    n[parent].height = n[sibling].height + 1;
+    n[parent].child1 = sibling;
+    n[parent].child2 = leaf;
+    n[sibling].parent = parent;
+    n[leaf].parent = parent;
+    if (old_parent != BVH_NULL) {
+        if (n[old_parent].child1 == sibling) n[old_parent].child1 = parent;
+        else n[old_parent].child2 = parent;
+    } else {
+        bvh->root = parent;
+    }
+
+    refit_upwards(bvh, n[leaf].parent);
+    return 1;
+}
+
+static void remove_leaf(Bvh* bvh, int leaf) {
+    BvhNode* n = bvh->nodes;
+    if (leaf == bvh->root) {
+        bvh->root = BVH_NULL;
+        return;
+    }
+
+    int parent = n[leaf].parent;
+    int grand = n[parent].parent;
+    int sibling = n[parent].child1 == leaf ? n[parent].child2 : n[parent].child1;
+    n[sibling].parent = grand;
+    if (grand != BVH_NULL) {
+        if (n[grand].child1 == parent) n[grand].child1 = sibling;
+        else n[grand].child2 = sibling;
+    } else {
+        bvh->root = sibling;
+    }
+    free_node(bvh, parent);
+    refit_upwards(bvh, grand);
+}
+
+static Aabb fatten(Aabb a) {
+    const Vec3 m = { BVH_FAT_MARGIN, BVH_FAT_MARGIN, BVH_FAT_MARGIN };
+    return (Aabb){ vec3_sub(a.min, m), vec3_add(a.max, m) };
+}
+
+int bvh_insert(Bvh* bvh, Vec3 min, Vec3 max, uint32_t user) {
+    int leaf = alloc_node(bvh);
+    if (leaf == BVH_NULL) return -1;
+    BvhNode* n = &bvh->nodes[leaf];
+    n->tight = (Aabb){ min, max };
+    n->box = fatten(n->tight);
+    n->user = user;
+    if (!insert_leaf(bvh, leaf)) {
+        free_node(bvh, leaf);
+        return -1;
+    }
+    bvh->leaf_count++;
+    return leaf;
+}
+
+void bvh_remove(Bvh* bvh, int proxy) {
+    remove_leaf(bvh, proxy);
+    free_node(bvh, proxy);
+    bvh->leaf_count--;
+}
+
+int bvh_move(Bvh* bvh, int proxy, Vec3 min, Vec3 max) {
+    BvhNode* n = &bvh->nodes[proxy];
+    Aabb tight = { min, max };
+    n->tight = tight;
+    if (aabb_contains(n->box, tight)) return 0;
+
+    // Removing the leaf frees its parent node, so the reinsert never needs to grow the pool.
+    remove_leaf(bvh, proxy);
+    bvh->nodes[proxy].box = fatten(tight);
+    insert_leaf(bvh, proxy);
+    return 1;
+}
+
+uint32_t bvh_user(const Bvh* bvh, int proxy) {
+    return bvh->nodes[proxy].user;
+}
+
+size_t bvh_count(const Bvh* bvh) {
+    return bvh->leaf_count;
+}
+
+int bvh_height(const Bvh* bvh) {
+    return bvh->root == BVH_NULL ? -1 : bvh->nodes[bvh->root].height;
+}
+
+// Appends every leaf under `index` without testing it.
+static size_t collect_subtree(const Bvh* bvh, int index, uint32_t* out, size_t count, size_t cap) {
+    int stack[BVH_STACK];
+    int top = 0;
+    stack[top++] = index;
+    while (top > 0 && count < cap) {
+        const BvhNode* n = &bvh->nodes[stack[--top]];
+        if (n->height == 0) {
+            out[count++] = n->user;
+        } else if (top + 2 <= BVH_STACK) {
+            stack[top++] = n->child2;
+            stack[top++] = n->child1;
+        }
+    }
+    return count;
+}
+
+size_t bvh_query_frustum(const Bvh* bvh, const Frustum* frustum, uint32_t* out, size_t cap) {
+    size_t count = 0;
+    if (bvh->root == BVH_NULL) return 0;
+
+    int stack[BVH_STACK];
+    int top = 0;
+    stack[top++] = bvh->root;
+    while (top > 0 && count < cap) {
+        int index = stack[--top];
+        const BvhNode* n = &bvh->nodes[index];
+        if (n->height == 0) {
+            if (frustum_classify(frustum, n->tight)) out[count++] = n->user;
+            continue;
+        }
+        int c = frustum_classify(frustum, n->box);
+        if (c == 2) {
+            // Fully inside: every leaf below is at least partially visible.
+            count = collect_subtree(bvh, index, out, count, cap);
+        } else if (c == 1 && top + 2 <= BVH_STACK) {
+            stack[top++] = n->child2;
+            stack[top++] = n->child1;
+        }
+    }
+    return count;
+}
+
+size_t bvh_query_aabb(const Bvh* bvh, Vec3 min, Vec3 max, uint32_t* out, size_t cap) {
+    size_t count = 0;
+    if (bvh->root == BVH_NULL) return 0;
+
+    Aabb box = { min, max };
+    int stack[BVH_STACK];
+    int top = 0;
+    stack[top++] = bvh->root;
+    while (top > 0 && count < cap) {
+        const BvhNode* n = &bvh->nodes[stack[--top]];
+        if (n->height == 0) {
+            if (aabb_overlaps(n->tight, box)) out[count++] = n->user;
+        } else if (aabb_overlaps(n->box, box) && top + 2 <= BVH_STACK) {
+            stack[top++] = n->child2;
+            stack[top++] = n->child1;
+        }
+    }
+    return count;
+}
+
+int bvh_query_nearest(const Bvh* bvh, Vec3 point, uint32_t* out_user, float* out_distance) {
+    if (bvh->root == BVH_NULL) return 0;
+
+    // Depth-first branch and bound: the nearer child is visited first, and subtrees whose
+    // box is no closer than the best leaf so far are skipped.
+    float best = FLT_MAX;
+    uint32_t best_user = 0;
+    int stack[BVH_STACK];
+    int top = 0;
+    stack[top++] = bvh->root;
+    while (top > 0) {
+        const BvhNode* n = &bvh->nodes[stack[--top]];
+        if (n->height == 0) {
+            float d = aabb_distance2(n->tight, point);
+            if (d < best) { best = d; best_user = n->user; }
+            continue;
+        }
+        if (aabb_distance2(n->box, point) >= best || top + 2 > BVH_STACK) continue;
+        float d1 = aabb_distance2(bvh->nodes[n->child1].box, point);
+        float d2 = aabb_distance2(bvh->nodes[n->child2].box, point);
+        if (d1 < d2) {
+            stack[top++] = n->child2;
+            stack[top++] = n->child1;
+        } else {
+            stack[top++] = n->child1;
+            stack[top++] = n->child2;
+        }
+    }
+    *out_user = best_user;
+    if (out_distance) *out_distance = sqrtf(best);
+    return 1;
+}
@@ -0,0 +1,41 @@
+#ifndef CORE_BVH_H
+#define CORE_BVH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "vec.h"
+#include "culling.h"
+
+// Dynamic AABB tree over object bounds. Each object is a leaf ("proxy") carrying a user
+// value, typically an index into the caller's object array. Leaves store their box grown
+// by BVH_FAT_MARGIN, so small movements refit nothing; larger ones reinsert just that leaf.
+// Inserts pick the cheapest sibling by surface area and rotations keep the tree balanced,
+// so queries are O(log n) in the number of leaves plus the number of hits.
+typedef struct Bvh Bvh;
+
+#define BVH_FAT_MARGIN 0.1f
+
+Bvh* bvh_create(void);
+void bvh_destroy(Bvh* bvh);
+
+// Returns the proxy id of the new leaf, or -1 if out of memory.
+int bvh_insert(Bvh* bvh, Vec3 min, Vec3 max, uint32_t user);
+void bvh_remove(Bvh* bvh, int proxy);
+// Updates a leaf's box. Returns 1 if the leaf was reinserted, 0 if the box still fits the
+// leaf's fat box and the tree was left as is.
+int bvh_move(Bvh* bvh, int proxy, Vec3 min, Vec3 max);
+
+uint32_t bvh_user(const Bvh* bvh, int proxy);
+size_t bvh_count(const Bvh* bvh);
+int bvh_height(const Bvh* bvh);
+
+// Queries write the user values of matching leaves to `out`, at most `cap` of them, and
+// return how many were written. Order follows the tree, not insertion.
+size_t bvh_query_frustum(const Bvh* bvh, const Frustum* frustum, uint32_t* out, size_t cap);
+size_t bvh_query_aabb(const Bvh* bvh, Vec3 min, Vec3 max, uint32_t* out, size_t cap);
+
+// Finds the leaf whose box is closest to `point` (0 if the point is inside it). Returns 0
+// if the tree is empty.
+int bvh_query_nearest(const Bvh* bvh, Vec3 point, uint32_t* out_user, float* out_distance);
+
+#endif // CORE_BVH_H
@@ -0,0 +1,89 @@
+#include "clip.h"
+
+enum {
+    CLIP_NEAR, CLIP_LEFT, CLIP_RIGHT, CLIP_BOTTOM, CLIP_TOP,
+    CLIP_PLANE_COUNT
+};
+
+// Signed distance-like value of p against a clip plane; >= 0 is inside. The side planes
+// sit on the guard band when `guard` is set and on the viewport edges otherwise.
+static float plane_dist(int plane, Vec4 p, int guard, ClipDepth depth) {
+    float w = guard ? CLIP_GUARD_BAND * p.w : p.w;
+    switch (plane) {
+    case CLIP_NEAR:   return depth == CLIP_DEPTH_REVERSED ? p.w - p.z : p.z + p.w;
+    case CLIP_LEFT:   return w + p.x;
+    case CLIP_RIGHT:  return w - p.x;
+    case CLIP_BOTTOM: return w + p.y;
+    default:          return w - p.y;
+    }
+}
+
+static uint32_t lerp_color(uint32_t a, uint32_t b, float t) {
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        float ca = (float)((a >> shift) & 0xFF), cb = (float)((b >> shift) & 0xFF);
+        out |= (uint32_t)(ca + (cb - ca) * t + 0.5f) << shift;
+    }
+    return out;
+}
+
+static ClipVertex lerp_vertex(ClipVertex a, ClipVertex b, float t) {
+    ClipVertex v;
+    v.pos = (Vec4){
+        a.pos.x + (b.pos.x - a.pos.x) * t,
+        a.pos.y + (b.pos.y - a.pos.y) * t,
+        a.pos.z + (b.pos.z - a.pos.z) * t,
+        a.pos.w + (b.pos.w - a.pos.w) * t
+    };
+    v.color = lerp_color(a.color, b.color, t);
+    return v;
+}
+
+int clip_triangle(const ClipVertex in[3], ClipVertex out[CLIP_MAX_VERTICES], ClipDepth depth) {
+    // Trivial reject: all three vertices outside the same viewport plane.
+    for (int p = 0; p < CLIP_PLANE_COUNT; ++p) {
+        if (plane_dist(p, in[0].pos, 0, depth) < 0.0f &&
+            plane_dist(p, in[1].pos, 0, depth) < 0.0f &&
+            plane_dist(p, in[2].pos, 0, depth) < 0.0f) return 0;
+    }
+
+    out[0] = in[0];
+    out[1] = in[1];
+    out[2] = in[2];
+    if (clip_vertex_inside(in[0].pos, depth) && clip_vertex_inside(in[1].pos, depth) &&
+        clip_vertex_inside(in[2].pos, depth))
+        return 3;
+
+    // Sutherland-Hodgman, ping-ponging between out and a scratch polygon.
+    ClipVertex scratch[CLIP_MAX_VERTICES];
+    ClipVertex* src = out;
+    ClipVertex* dst = scratch;
+    int n = 3;
+    for (int p = 0; p < CLIP_PLANE_COUNT && n > 0; ++p) {
+        int m = 0;
+        for (int i = 0; i < n; ++i) {
+            ClipVertex a = src[i], b = src[(i + 1) % n];
+            float da = plane_dist(p, a.pos, 1, depth), db = plane_dist(p, b.pos, 1, depth);
+            if (da >= 0.0f) dst[m++] = a;
+            // Always interpolate from the inside end, so an edge shared with a neighbouring
+            // triangle (walked the other way) gets a bit-identical new vertex: no cracks.
+            if (da >= 0.0f && db < 0.0f) dst[m++] = lerp_vertex(a, b, da / (da - db));
+            if (da < 0.0f && db >= 0.0f) dst[m++] = lerp_vertex(b, a, db / (db - da));
+        }
+        n = m;
+        ClipVertex* tmp = src; src = dst; dst = tmp;
+    }
+
+    if (src != out)
+        for (int i = 0; i < n; ++i) out[i] = src[i];
+    return n >= 3 ? n : 0;
+}
+
+Vec3 clip_to_screen(Vec4 p, int width, int height, ClipDepth depth) {
+    Vec3 ndc = { p.x / p.w, p.y / p.w, p.z / p.w };
+    return (Vec3){
+        (ndc.x + 1.0f) * 0.5f * width,
+        (1.0f - (ndc.y + 1.0f) * 0.5f) * height,
+        depth == CLIP_DEPTH_REVERSED ? ndc.z : (ndc.z + 1.0f) * 0.5f
+    };
+}
@@ -0,0 +1,48 @@
+#ifndef CORE_CLIP_H
+#define CORE_CLIP_H
+
+#include <stdint.h>
+#include "vec.h"
+
+// Guard band half-extent, in multiples of the viewport's half-size. Vertices inside it are
+// projected and rasterized directly (the rasterizer clamps to the screen); only triangles
+// reaching past it, or crossing the near plane, are clipped. At 4x a 1920-wide target
+// still keeps coordinates far inside the fixed-point rasterizer's range.
+#define CLIP_GUARD_BAND 4.0f
+
+// Near plane plus four guard-band planes can each add one vertex.
+#define CLIP_MAX_VERTICES 8
+
+// Depth convention of clip space. STANDARD is OpenGL's (mat4_perspective): -w <= z <= w
+// with the near plane at -w, and screen depth (z / w + 1) / 2. REVERSED
+// (mat4_perspective_reversed): 0 <= z <= w with the near plane at w, and screen depth z / w,
+// 1 near and 0 far. It follows from the target's depth format (renderer_get_clip_depth) and
+// travels with the projection to everything that clips or projects for that target.
+typedef enum {
+    CLIP_DEPTH_STANDARD = 0,
+    CLIP_DEPTH_REVERSED = 1
+} ClipDepth;
+
+// A clip-space vertex with its ARGB colour.
+typedef struct {
+    Vec4 pos;
+    uint32_t color;
+} ClipVertex;
+
+// 1 if the vertex is in front of the near plane and inside the guard band.
+static inline int clip_vertex_inside(Vec4 p, ClipDepth depth) {
+    float g = CLIP_GUARD_BAND * p.w;
+    int front = depth == CLIP_DEPTH_REVERSED ? p.z <= p.w : p.z >= -p.w;
+    return front && p.x <= g && p.x >= -g && p.y <= g && p.y >= -g;
+}
+
+// Clips a triangle against the near plane and the guard band. Writes a convex polygon
+// (fan order, same winding) to out and returns its vertex count: 0 when the triangle is
+// entirely outside the view volume, 3 when it needed no clipping.
+int clip_triangle(const ClipVertex in[3], ClipVertex out[CLIP_MAX_VERTICES], ClipDepth depth);
+
+// Perspective divide and viewport mapping, the same as geom_project_point; z maps to [0, 1]
+// as the depth convention says.
+Vec3 clip_to_screen(Vec4 p, int width, int height, ClipDepth depth);
+
+#endif // CORE_CLIP_H
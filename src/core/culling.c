@@ -1,19 +1,121 @@
 #include "culling.h"
 #include <math.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
-int sphere_in_frustum(Mat4 view, Vec3 world_center, float radius, int width, int height, float fov, float near_plane, float far_plane) {
-    Vec3 view_center = mat4_mul_vec3(view, world_center);
-    float view_depth = -view_center.z; // positive in front
-    float tan_half = tanf(fov * 0.5f);
-    float aspect = (float)width / (float)height;
-    float x_limit = view_depth * tan_half * aspect;
-    float y_limit = view_depth * tan_half;
-
-    if ((view_depth - radius) > far_plane) return 0;
-    if ((view_depth + radius) < near_plane) return 0;
-    if (view_depth > 0.0f) {
-        if ((fabsf(view_center.x) - radius) > x_limit) return 0;
-        if ((fabsf(view_center.y) - radius) > y_limit) return 0;
+static Vec4 normalize_plane(float a, float b, float c, float d) {
+    float len = sqrtf(a*a + b*b + c*c);
+    float inv = len > 0.0f ? 1.0f / len : 0.0f;
+    return (Vec4){ a * inv, b * inv, c * inv, d * inv };
+}
+
+// Plane of the clip-space bound s*row[i] + t*row3 >= 0, normalized.
+static Vec4 clip_plane(Mat4 m, int i, float s, float t) {
+    return normalize_plane(s * m.m[i][0] + t * m.m[3][0], s * m.m[i][1] + t * m.m[3][1],
+                           s * m.m[i][2] + t * m.m[3][2], s * m.m[i][3] + t * m.m[3][3]);
+}
+
+Frustum frustum_from_matrix(Mat4 m, ClipDepth depth) {
+    // Gribb/Hartmann: each clip-space bound (e.g. -w <= x) is a row combination of m.
+    Frustum f;
+    f.planes[FRUSTUM_LEFT]   = clip_plane(m, 0,  1.0f, 1.0f);   // -w <= x
+    f.planes[FRUSTUM_RIGHT]  = clip_plane(m, 0, -1.0f, 1.0f);   //  x <= w
+    f.planes[FRUSTUM_BOTTOM] = clip_plane(m, 1,  1.0f, 1.0f);   // -w <= y
+    f.planes[FRUSTUM_TOP]    = clip_plane(m, 1, -1.0f, 1.0f);   //  y <= w
+    if (depth == CLIP_DEPTH_REVERSED) {
+        // Reversed depth maps the near plane to z = w and the far plane to z = 0.
+        f.planes[FRUSTUM_NEAR] = clip_plane(m, 2, -1.0f, 1.0f); //  z <= w
+        f.planes[FRUSTUM_FAR]  = clip_plane(m, 2,  1.0f, 0.0f); //  0 <= z
+    } else {
+        f.planes[FRUSTUM_NEAR] = clip_plane(m, 2,  1.0f, 1.0f); // -w <= z
+        f.planes[FRUSTUM_FAR]  = clip_plane(m, 2, -1.0f, 1.0f); //  z <= w
+    }
+    return f;
+}
+
+static inline float plane_distance(Vec4 p, float x, float y, float z) {
+    return p.x * x + p.y * y + p.z * z + p.w;
+}
+
+int frustum_test_sphere(const Frustum* f, Vec3 c, float radius) {
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i)
+        if (plane_distance(f->planes[i], c.x, c.y, c.z) < -radius) return 0;
+    return 1;
+}
+
+int frustum_test_aabb(const Frustum* f, Vec3 mn, Vec3 mx) {
+    // Only the corner furthest along each plane's normal needs testing.
+    for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+        Vec4 p = f->planes[i];
+        float x = p.x >= 0.0f ? mx.x : mn.x;
+        float y = p.y >= 0.0f ? mx.y : mn.y;
+        float z = p.z >= 0.0f ? mx.z : mn.z;
+        if (plane_distance(p, x, y, z) < 0.0f) return 0;
     }
     return 1;
 }
+
+#if defined(__AVX2__)
+// Appends the indices base + k of the set bits k of `mask`.
+static inline size_t emit_visible(int mask, size_t base, uint32_t* out) {
+    size_t n = 0;
+    while (mask) {
+        int k = __builtin_ctz((unsigned)mask);
+        out[n++] = (uint32_t)(base + (size_t)k);
+        mask &= mask - 1;
+    }
+    return n;
+}
+
+static inline __m256 plane_lanes(Vec4 p, __m256 x, __m256 y, __m256 z) {
+    // Same evaluation order as plane_distance, so both paths agree on boundary cases.
+    __m256 d = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.x), x), _mm256_mul_ps(_mm256_set1_ps(p.y), y));
+    d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(p.z), z));
+    return _mm256_add_ps(d, _mm256_set1_ps(p.w));
+}
+#endif
+
+// Both batch functions test eight volumes per iteration against all six planes; the
+// remainder (and non-AVX2 builds) go through the single-volume tests.
+size_t frustum_cull_spheres(const Frustum* f, const float* x, const float* y, const float* z,
+                            const float* radius, size_t count, uint32_t* out_visible) {
+    size_t n = 0, i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8) {
+        __m256 cx = _mm256_loadu_ps(&x[i]), cy = _mm256_loadu_ps(&y[i]), cz = _mm256_loadu_ps(&z[i]);
+        __m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&radius[i]));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < FRUSTUM_PLANE_COUNT; ++p)
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(plane_lanes(f->planes[p], cx, cy, cz), neg_r, _CMP_NLT_UQ));
+        n += emit_visible(_mm256_movemask_ps(inside), i, &out_visible[n]);
+    }
+#endif
+    for (; i < count; ++i)
+        if (frustum_test_sphere(f, (Vec3){x[i], y[i], z[i]}, radius[i])) out_visible[n++] = (uint32_t)i;
+    return n;
+}
+
+size_t frustum_cull_aabbs(const Frustum* f,
+                          const float* min_x, const float* min_y, const float* min_z,
+                          const float* max_x, const float* max_y, const float* max_z,
+                          size_t count, uint32_t* out_visible) {
+    size_t n = 0, i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8) {
+        __m256 lx = _mm256_loadu_ps(&min_x[i]), ly = _mm256_loadu_ps(&min_y[i]), lz = _mm256_loadu_ps(&min_z[i]);
+        __m256 hx = _mm256_loadu_ps(&max_x[i]), hy = _mm256_loadu_ps(&max_y[i]), hz = _mm256_loadu_ps(&max_z[i]);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+            Vec4 pl = f->planes[p];
+            __m256 d = plane_lanes(pl, pl.x >= 0.0f ? hx : lx, pl.y >= 0.0f ? hy : ly, pl.z >= 0.0f ? hz : lz);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_NLT_UQ));
+        }
+        n += emit_visible(_mm256_movemask_ps(inside), i, &out_visible[n]);
+    }
+#endif
+    for (; i < count; ++i)
+        if (frustum_test_aabb(f, (Vec3){min_x[i], min_y[i], min_z[i]}, (Vec3){max_x[i], max_y[i], max_z[i]}))
+            out_visible[n++] = (uint32_t)i;
+    return n;
+}
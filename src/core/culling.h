@@ -1,9 +1,39 @@
 #ifndef CORE_CULLING_H
 #define CORE_CULLING_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include "mat.h"
 #include "vec.h"
+#include "clip.h"
 
-int sphere_in_frustum(Mat4 view, Vec3 world_center, float radius, int width, int height, float fov, float near_plane, float far_plane);
+enum {
+    FRUSTUM_LEFT, FRUSTUM_RIGHT, FRUSTUM_BOTTOM, FRUSTUM_TOP, FRUSTUM_NEAR, FRUSTUM_FAR,
+    FRUSTUM_PLANE_COUNT
+};
+
+// View frustum as six world-space planes: a point p is inside plane (a, b, c, d) when
+// a*p.x + b*p.y + c*p.z + d >= 0. Normals are unit length, so that value is a distance.
+// Build it once per frame and share it between all culling calls.
+typedef struct {
+    Vec4 planes[FRUSTUM_PLANE_COUNT];
+} Frustum;
+
+// Extracts the planes of proj * view, whose clip space follows `depth`. FRUSTUM_NEAR and
+// FRUSTUM_FAR name the camera's near and far planes under either convention.
+Frustum frustum_from_matrix(Mat4 view_proj, ClipDepth depth);
+
+int frustum_test_sphere(const Frustum* f, Vec3 center, float radius);
+int frustum_test_aabb(const Frustum* f, Vec3 min, Vec3 max);
+
+// Batch culling over SoA bounding volumes. Indices of the volumes that may be visible are
+// written to out_visible in ascending order; returns how many. out_visible must hold
+// `count` entries.
+size_t frustum_cull_spheres(const Frustum* f, const float* x, const float* y, const float* z,
+                            const float* radius, size_t count, uint32_t* out_visible);
+size_t frustum_cull_aabbs(const Frustum* f,
+                          const float* min_x, const float* min_y, const float* min_z,
+                          const float* max_x, const float* max_y, const float* max_z,
+                          size_t count, uint32_t* out_visible);
 
 #endif // CORE_CULLING_H
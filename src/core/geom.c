@@ -4,13 +4,14 @@
 
 extern Vec3 ndc_to_screen(Vec3 v, int width, int height);
 
-int geom_project_point(Mat4 view, Mat4 proj, Vec3 world, int width, int height, Vec3* out_screen, Vec3* out_view_space) {
+int geom_project_point(Mat4 view, Mat4 proj, ClipDepth depth, Vec3 world, int width, int height, Vec3* out_screen,
+                       Vec3* out_view_space) {
     Vec3 view_space = mat4_mul_vec3(view, world);
     if (out_view_space) *out_view_space = view_space;
     Vec4 clip = mat4_mul_vec4(proj, (Vec4){view_space.x, view_space.y, view_space.z, 1.0f});
     if (clip.w <= 1e-6f) return 0;
     Vec3 ndc = { clip.x/clip.w, clip.y/clip.w, clip.z/clip.w };
-    ndc.z = (ndc.z+1.0f)*0.5f;
+    if (depth == CLIP_DEPTH_STANDARD) ndc.z = (ndc.z+1.0f)*0.5f;
     if (out_screen) *out_screen = ndc_to_screen(ndc, width, height);
     return 1;
 }
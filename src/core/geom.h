@@ -3,12 +3,15 @@
 
 #include "mat.h"
 #include "vec.h"
+#include "clip.h"
 
 static inline Vec3 geom_transform_point(Mat4 m, Vec3 v) {
     return mat4_mul_vec3(m, v);
 }
 
-int geom_project_point(Mat4 view, Mat4 proj, Vec3 world, int width, int height, Vec3* out_screen, Vec3* out_view_space);
+// Screen depth maps to [0, 1] as `depth`, the convention of proj, says.
+int geom_project_point(Mat4 view, Mat4 proj, ClipDepth depth, Vec3 world, int width, int height, Vec3* out_screen,
+                       Vec3* out_view_space);
 
 int geom_triangle_backface_cull(const Vec3 screen[3]);
 
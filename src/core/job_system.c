@@ -0,0 +1,331 @@
+#define _GNU_SOURCE
+#include "job_system.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "core/arena.h"
+#include "core/memory.h"
+
+// Per-deque ring capacity, a power of two. A run that finds its deque full executes the
+// overflow on the caller instead.
+#define JOB_DEQUE_CAPACITY 1024
+#define JOB_SYSTEM_MAX_THREADS 64
+
+typedef struct {
+    JobFn fn;
+    void* ctx;
+    int begin, end;
+    JobCounter* counter;
+} Job;
+
+// Owner end is the back (tail), thieves take from the front (head). A short mutex per deque
+// keeps owner and thieves apart; they only meet when a deque is nearly empty.
+typedef struct {
+    pthread_mutex_t mutex;
+    Job jobs[JOB_DEQUE_CAPACITY];
+    unsigned head, tail;
+} JobDeque;
+
+// One per background worker plus a last one shared by every other thread. Statistics are
+// updated atomically since the shared slot has several writers.
+typedef struct {
+    JobSystem* js;
+    int index;
+    pthread_t thread;
+    JobDeque deque;
+    uint64_t busy_ns, idle_ns;
+    uint32_t jobs, steals;
+} JobWorker;
+
+struct JobSystem {
+    JobWorker* workers;  // worker_count + 1 slots, the last one external
+    int worker_count;
+    int started;
+    int flags;
+    int run_inline;
+
+    pthread_key_t self;  // JobWorker* of the calling worker thread, NULL elsewhere
+
+    // Sleeping threads wait for queued jobs (pending) or a finished counter.
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    int pending;
+    int shutdown;
+
+    // Workers that have finished their setup; create waits on `ready` until all have.
+    pthread_cond_t ready;
+    int initialized;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static JobWorker* current_worker(JobSystem* js) {
+    JobWorker* w = pthread_getspecific(js->self);
+    return w ? w : &js->workers[js->worker_count];
+}
+
+static int deque_push(JobDeque* d, const Job* job) {
+    pthread_mutex_lock(&d->mutex);
+    int ok = d->tail - d->head < JOB_DEQUE_CAPACITY;
+    if (ok) {
+        d->jobs[d->tail % JOB_DEQUE_CAPACITY] = *job;
+        __atomic_store_n(&d->tail, d->tail + 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&d->mutex);
+    return ok;
+}
+
+static int deque_pop_back(JobDeque* d, Job* job) {
+    pthread_mutex_lock(&d->mutex);
+    int ok = d->tail != d->head;
+    if (ok) {
+        *job = d->jobs[(d->tail - 1) % JOB_DEQUE_CAPACITY];
+        __atomic_store_n(&d->tail, d->tail - 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&d->mutex);
+    return ok;
+}
+
+static int deque_steal_front(JobDeque* d, Job* job) {
+    // Unlocked peek first so scanning empty deques does not bounce their locks around.
+    if (__atomic_load_n(&d->tail, __ATOMIC_RELAXED) == __atomic_load_n(&d->head, __ATOMIC_RELAXED))
+        return 0;
+    pthread_mutex_lock(&d->mutex);
+    int ok = d->tail != d->head;
+    if (ok) {
+        *job = d->jobs[d->head % JOB_DEQUE_CAPACITY];
+        __atomic_store_n(&d->head, d->head + 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&d->mutex);
+    return ok;
+}
+
+// Own deque first, then the others starting with the next slot so thieves spread out.
+static int take_job(JobSystem* js, JobWorker* self, Job* job) {
+    if (__atomic_load_n(&js->pending, __ATOMIC_ACQUIRE) == 0) return 0;
+
+    int found = deque_pop_back(&self->deque, job);
+    for (int i = 1; !found && i <= js->worker_count; ++i) {
+        JobWorker* victim = &js->workers[(self->index + i) % (js->worker_count + 1)];
+        if (deque_steal_front(&victim->deque, job)) {
+            found = 1;
+            __atomic_fetch_add(&self->steals, 1, __ATOMIC_RELAXED);
+        }
+    }
+    if (found) __atomic_fetch_sub(&js->pending, 1, __ATOMIC_ACQ_REL);
+    return found;
+}
+
+static void wake_all(JobSystem* js) {
+    pthread_mutex_lock(&js->mutex);
+    pthread_cond_broadcast(&js->wake);
+    pthread_mutex_unlock(&js->mutex);
+}
+
+static void execute_job(JobSystem* js, JobWorker* self, const Job* job) {
+    uint64_t start = now_ns();
+    for (int i = job->begin; i < job->end; ++i) job->fn(job->ctx, i);
+    __atomic_fetch_add(&self->busy_ns, now_ns() - start, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&self->jobs, 1, __ATOMIC_RELAXED);
+
+    if (job->counter && __atomic_sub_fetch(&job->counter->value, 1, __ATOMIC_ACQ_REL) == 0)
+        wake_all(js);
+}
+
+static void pin_thread(int cpu) {
+#if defined(__linux__)
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus <= 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+static void* worker_main(void* arg) {
+    JobWorker* self = arg;
+    JobSystem* js = self->js;
+    pthread_setspecific(js->self, self);
+    // Core 0 is left to the main thread.
+    if (js->flags & JOB_SYSTEM_PIN_THREADS) pin_thread(self->index + 1);
+    // Jobs take their temporaries from it. Creating it before create returns keeps the
+    // allocation out of the first frame this worker helps with, however late it starts.
+    arena_thread_scratch();
+    pthread_mutex_lock(&js->mutex);
+    js->initialized++;
+    pthread_cond_broadcast(&js->ready);
+    pthread_mutex_unlock(&js->mutex);
+
+    for (;;) {
+        Job job;
+        if (take_job(js, self, &job)) {
+            execute_job(js, self, &job);
+            continue;
+        }
+
+        uint64_t start = now_ns();
+        pthread_mutex_lock(&js->mutex);
+        while (!js->shutdown && __atomic_load_n(&js->pending, __ATOMIC_ACQUIRE) == 0)
+            pthread_cond_wait(&js->wake, &js->mutex);
+        int done = js->shutdown && __atomic_load_n(&js->pending, __ATOMIC_ACQUIRE) == 0;
+        pthread_mutex_unlock(&js->mutex);
+        __atomic_fetch_add(&self->idle_ns, now_ns() - start, __ATOMIC_RELAXED);
+        if (done) break;
+    }
+    return NULL;
+}
+
+JobSystem* job_system_create(int thread_count, int flags) {
+    if (thread_count <= 0) thread_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > JOB_SYSTEM_MAX_THREADS) thread_count = JOB_SYSTEM_MAX_THREADS;
+
+    JobSystem* js = mem_calloc(1, sizeof(JobSystem), MEM_TAG_JOBS);
+    if (!js) return NULL;
+    js->workers = mem_calloc((size_t)thread_count, sizeof(JobWorker), MEM_TAG_JOBS);
+    if (!js->workers || pthread_key_create(&js->self, NULL) != 0) {
+        mem_free(js->workers);
+        mem_free(js);
+        return NULL;
+    }
+    js->flags = flags;
+    js->run_inline = (flags & JOB_SYSTEM_INLINE) != 0;
+    js->worker_count = thread_count - 1;
+    pthread_mutex_init(&js->mutex, NULL);
+    pthread_cond_init(&js->wake, NULL);
+    pthread_cond_init(&js->ready, NULL);
+    for (int i = 0; i < thread_count; ++i) {
+        js->workers[i].js = js;
+        js->workers[i].index = i;
+        pthread_mutex_init(&js->workers[i].deque.mutex, NULL);
+    }
+
+    for (int i = 0; i < js->worker_count; ++i) {
+        if (pthread_create(&js->workers[i].thread, NULL, worker_main, &js->workers[i]) != 0) break;
+        js->started++;
+    }
+    pthread_mutex_lock(&js->mutex);
+    while (js->initialized < js->started) pthread_cond_wait(&js->ready, &js->mutex);
+    pthread_mutex_unlock(&js->mutex);
+    // Workers that failed to start just leave their deque empty; with none at all every
+    // run executes on its caller.
+    if (js->started == 0) js->run_inline = 1;
+    return js;
+}
+
+void job_system_destroy(JobSystem* js) {
+    if (!js) return;
+
+    pthread_mutex_lock(&js->mutex);
+    js->shutdown = 1;
+    pthread_cond_broadcast(&js->wake);
+    pthread_mutex_unlock(&js->mutex);
+    for (int i = 0; i < js->started; ++i) pthread_join(js->workers[i].thread, NULL);
+
+    for (int i = 0; i <= js->worker_count; ++i) pthread_mutex_destroy(&js->workers[i].deque.mutex);
+    pthread_cond_destroy(&js->wake);
+    pthread_cond_destroy(&js->ready);
+    pthread_mutex_destroy(&js->mutex);
+    pthread_key_delete(js->self);
+    mem_free(js->workers);
+    mem_free(js);
+}
+
+int job_system_thread_count(const JobSystem* js) {
+    return js ? js->started + 1 : 1;
+}
+
+void job_system_set_inline(JobSystem* js, int run_inline) {
+    if (!js) return;
+    __atomic_store_n(&js->run_inline, run_inline || js->started == 0, __ATOMIC_RELAXED);
+}
+
+void job_system_run(JobSystem* js, JobFn fn, void* ctx, int count, int batch, JobCounter* counter) {
+    if (count <= 0) return;
+    if (batch < 1) batch = 1;
+
+    if (!js || __atomic_load_n(&js->run_inline, __ATOMIC_RELAXED)) {
+        for (int i = 0; i < count; ++i) fn(ctx, i);
+        return;
+    }
+
+    int job_count = (count + batch - 1) / batch;
+    if (counter) __atomic_fetch_add(&counter->value, job_count, __ATOMIC_ACQ_REL);
+
+    JobWorker* self = current_worker(js);
+    int queued = 0;
+    for (int begin = 0; begin < count; begin += batch) {
+        Job job = { fn, ctx, begin, begin + batch < count ? begin + batch : count, counter };
+        // Count it before it becomes visible, so pending never undercounts the deques.
+        __atomic_fetch_add(&js->pending, 1, __ATOMIC_ACQ_REL);
+        if (deque_push(&self->deque, &job)) {
+            queued++;
+        } else {
+            __atomic_fetch_sub(&js->pending, 1, __ATOMIC_ACQ_REL);
+            execute_job(js, self, &job);
+        }
+    }
+    if (queued > 0) wake_all(js);
+}
+
+void job_system_wait(JobSystem* js, JobCounter* counter) {
+    if (!js || !counter) return;
+
+    JobWorker* self = current_worker(js);
+    while (__atomic_load_n(&counter->value, __ATOMIC_ACQUIRE) > 0) {
+        Job job;
+        if (take_job(js, self, &job)) {
+            execute_job(js, self, &job);
+            continue;
+        }
+
+        // The last jobs of this counter are running elsewhere: sleep until one finishes
+        // or new work shows up.
+        uint64_t start = now_ns();
+        pthread_mutex_lock(&js->mutex);
+        while (__atomic_load_n(&counter->value, __ATOMIC_ACQUIRE) > 0 &&
+               __atomic_load_n(&js->pending, __ATOMIC_ACQUIRE) == 0)
+            pthread_cond_wait(&js->wake, &js->mutex);
+        pthread_mutex_unlock(&js->mutex);
+        __atomic_fetch_add(&self->idle_ns, now_ns() - start, __ATOMIC_RELAXED);
+    }
+}
+
+int job_counter_done(const JobCounter* counter) {
+    return !counter || __atomic_load_n(&counter->value, __ATOMIC_ACQUIRE) == 0;
+}
+
+void job_system_parallel_for(JobSystem* js, JobFn fn, void* ctx, int count, int batch) {
+    // A single job would only be handed to another thread while this one waits for it.
+    if (count <= batch) {
+        for (int i = 0; i < count; ++i) fn(ctx, i);
+        return;
+    }
+    JobCounter counter = {0};
+    job_system_run(js, fn, ctx, count, batch, &counter);
+    job_system_wait(js, &counter);
+}
+
+int job_system_take_stats(JobSystem* js, JobWorkerStats* out, int max) {
+    if (!js) return 0;
+    int n = 0;
+    for (int i = 0; i <= js->worker_count && n < max; ++i) {
+        JobWorker* w = &js->workers[i];
+        if (i < js->worker_count && i >= js->started) continue;
+        out[n].busy_ms = (double)__atomic_exchange_n(&w->busy_ns, 0, __ATOMIC_RELAXED) / 1e6;
+        out[n].idle_ms = (double)__atomic_exchange_n(&w->idle_ns, 0, __ATOMIC_RELAXED) / 1e6;
+        out[n].jobs = __atomic_exchange_n(&w->jobs, 0, __ATOMIC_RELAXED);
+        out[n].steals = __atomic_exchange_n(&w->steals, 0, __ATOMIC_RELAXED);
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,71 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <stdint.h>
+
+// Work-stealing job system shared by the engine: one worker thread per core, each with its
+// own deque. A thread pushes and pops its own jobs at the back (newest first, still warm in
+// cache) and idle threads steal from the front of the others. Threads that are not
+// workers (main, raster) share one extra deque.
+//
+// Every call accepts a NULL system and then runs the work inline on the caller, so
+// subsystems can take an optional JobSystem* without special cases.
+typedef struct JobSystem JobSystem;
+
+// Called once per item index; items of one run may execute on any thread in any order.
+typedef void (*JobFn)(void* ctx, int index);
+
+// Dependency counter: job_system_run adds the jobs it schedules and each one subtracts
+// itself when done, so zero means everything attached to it finished. Zero-initialise it;
+// one counter may collect several runs.
+typedef struct {
+    int value;
+} JobCounter;
+
+// Creation flags.
+enum {
+    JOB_SYSTEM_PIN_THREADS = 1 << 0,  // pin worker i to core i + 1 (Linux only)
+    JOB_SYSTEM_INLINE      = 1 << 1,  // start in inline mode, see job_system_set_inline
+};
+
+// Creates a system that runs jobs on `thread_count` threads in total: the threads that
+// wait on counters plus thread_count - 1 background workers. 0 uses one per core.
+JobSystem* job_system_create(int thread_count, int flags);
+// Stops the workers. Nothing may be running or waited on.
+void job_system_destroy(JobSystem* js);
+
+int job_system_thread_count(const JobSystem* js);
+
+// Debugging aid: while on, every run executes immediately on the caller in index order,
+// so the whole frame is single-threaded and deterministic.
+void job_system_set_inline(JobSystem* js, int run_inline);
+
+// Schedules fn(ctx, i) for every i in [0, count), `batch` consecutive indices per job, and
+// returns without waiting. counter may be NULL for fire-and-forget work.
+void job_system_run(JobSystem* js, JobFn fn, void* ctx, int count, int batch, JobCounter* counter);
+
+// Runs queued jobs (anyone's) until the counter drops to zero, sleeping only when there is
+// nothing to take. Jobs may wait on counters themselves: the waiting thread keeps working,
+// so dependency chains never park a worker.
+void job_system_wait(JobSystem* js, JobCounter* counter);
+
+// Non-blocking check for a counter, e.g. background work polled once per frame.
+int job_counter_done(const JobCounter* counter);
+
+// job_system_run followed by job_system_wait.
+void job_system_parallel_for(JobSystem* js, JobFn fn, void* ctx, int count, int batch);
+
+// Time a thread spent running jobs vs. sleeping for lack of them, since the last
+// job_system_take_stats.
+typedef struct {
+    double busy_ms;
+    double idle_ms;
+    uint32_t jobs;    // jobs executed
+    uint32_t steals;  // of those, taken from another thread's deque
+} JobWorkerStats;
+
+// Copies out and resets the statistics of up to `max` threads: the background workers
+// first, then one entry covering all non-worker threads. Returns the number written.
+int job_system_take_stats(JobSystem* js, JobWorkerStats* out, int max);
+
+#endif // JOB_SYSTEM_H
@@ -90,6 +90,18 @@ Mat4 mat4_perspective(float fov, float aspect, float near, float far) {
     return m;
 }
 
+Mat4 mat4_perspective_reversed(float fov, float aspect, float near, float far) {
+    float f = 1.0f / tanf(fov / 2.0f);
+    Mat4 m;
+    memset(&m, 0, sizeof(m));
+    m.m[0][0] = f / aspect;
+    m.m[1][1] = f;
+    m.m[2][2] = near / (far - near);
+    m.m[2][3] = (far * near) / (far - near);
+    m.m[3][2] = -1.0f;
+    return m;
+}
+
 Vec3 mat4_mul_vec3(Mat4 m, Vec3 v) {
     Vec4 r4 = mat4_mul_vec4(m, (Vec4){ v.x, v.y, v.z, 1.0f });
     if (fabsf(r4.w) > 1e-9f) {
@@ -19,5 +19,8 @@ Mat4 mat4_rotation_x(float radians);
 Mat4 mat4_rotation_y(float radians);
 Mat4 mat4_rotation_z(float radians);
 Mat4 mat4_perspective(float fov, float aspect, float near, float far);
+// Reversed-Z counterpart for CLIP_DEPTH_REVERSED: clip z runs from w at the near plane down
+// to 0 at the far one, with no constant added that would swamp far depths in float.
+Mat4 mat4_perspective_reversed(float fov, float aspect, float near, float far);
 
 #endif // MAT_H
@@ -0,0 +1,110 @@
+#include "memory.h"
+#include <stdlib.h>
+#include <string.h>
+#include "core/log.h"
+
+// Sixteen bytes keep the block behind the header as aligned as malloc's own result.
+typedef struct {
+    size_t size;
+    size_t tag;
+} MemHeader;
+
+// Violations logged in full; later ones are only counted.
+#define MEM_GUARD_LOG_LIMIT 8
+
+static const char* tag_names[MEM_TAG_COUNT] = { "assets", "scene", "renderer", "arena", "jobs" };
+
+// Updated from any thread, hence the atomics.
+static MemTagStats stats[MEM_TAG_COUNT];
+static int guard_mode = MEM_GUARD_OFF;
+static size_t guard_violations = 0;
+
+static void check_guard(MemTag tag, size_t size) {
+    int mode = __atomic_load_n(&guard_mode, __ATOMIC_RELAXED);
+    if (mode == MEM_GUARD_OFF) return;
+
+    size_t n = __atomic_add_fetch(&guard_violations, 1, __ATOMIC_RELAXED);
+    if (mode == MEM_GUARD_ABORT)
+        LOG_FATAL("heap allocation in steady state: %zu bytes (%s)", size, tag_names[tag]);
+    if (n <= MEM_GUARD_LOG_LIMIT)
+        LOG_WARN("heap allocation in steady state: %zu bytes (%s)", size, tag_names[tag]);
+}
+
+static void account(MemTag tag, size_t old_size, size_t new_size, int live_delta) {
+    MemTagStats* s = &stats[tag];
+    size_t bytes;
+    if (new_size >= old_size) bytes = __atomic_add_fetch(&s->bytes, new_size - old_size, __ATOMIC_RELAXED);
+    else bytes = __atomic_sub_fetch(&s->bytes, old_size - new_size, __ATOMIC_RELAXED);
+    if (live_delta > 0) __atomic_add_fetch(&s->live, 1, __ATOMIC_RELAXED);
+    if (live_delta < 0) __atomic_sub_fetch(&s->live, 1, __ATOMIC_RELAXED);
+
+    size_t peak = __atomic_load_n(&s->peak_bytes, __ATOMIC_RELAXED);
+    while (bytes > peak &&
+           !__atomic_compare_exchange_n(&s->peak_bytes, &peak, bytes, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void* mem_alloc(size_t size, MemTag tag) {
+    if (size > (size_t)-1 - sizeof(MemHeader)) return NULL;
+    check_guard(tag, size);
+
+    MemHeader* h = malloc(sizeof(MemHeader) + size);
+    if (!h) return NULL;
+    h->size = size;
+    h->tag = (size_t)tag;
+    __atomic_add_fetch(&stats[tag].allocations, 1, __ATOMIC_RELAXED);
+    account(tag, 0, size, 1);
+    return h + 1;
+}
+
+void* mem_calloc(size_t count, size_t size, MemTag tag) {
+    if (size && count > (size_t)-1 / size) return NULL;
+    void* p = mem_alloc(count * size, tag);
+    if (p) memset(p, 0, count * size);
+    return p;
+}
+
+void* mem_realloc(void* ptr, size_t size, MemTag tag) {
+    if (!ptr) return mem_alloc(size, tag);
+    if (size > (size_t)-1 - sizeof(MemHeader)) return NULL;
+
+    MemHeader* h = (MemHeader*)ptr - 1;
+    MemTag old_tag = (MemTag)h->tag;
+    size_t old_size = h->size;
+    check_guard(old_tag, size);
+
+    MemHeader* nh = realloc(h, sizeof(MemHeader) + size);
+    if (!nh) return NULL;
+    nh->size = size;
+    __atomic_add_fetch(&stats[old_tag].allocations, 1, __ATOMIC_RELAXED);
+    account(old_tag, old_size, size, 0);
+    return nh + 1;
+}
+
+void mem_free(void* ptr) {
+    if (!ptr) return;
+    MemHeader* h = (MemHeader*)ptr - 1;
+    account((MemTag)h->tag, h->size, 0, -1);
+    free(h);
+}
+
+MemTagStats mem_tag_stats(MemTag tag) {
+    MemTagStats s;
+    s.bytes = __atomic_load_n(&stats[tag].bytes, __ATOMIC_RELAXED);
+    s.peak_bytes = __atomic_load_n(&stats[tag].peak_bytes, __ATOMIC_RELAXED);
+    s.live = __atomic_load_n(&stats[tag].live, __ATOMIC_RELAXED);
+    s.allocations = __atomic_load_n(&stats[tag].allocations, __ATOMIC_RELAXED);
+    return s;
+}
+
+const char* mem_tag_name(MemTag tag) {
+    return (unsigned)tag < MEM_TAG_COUNT ? tag_names[tag] : "?";
+}
+
+void mem_guard_set(MemGuardMode mode) {
+    __atomic_store_n(&guard_mode, (int)mode, __ATOMIC_RELAXED);
+}
+
+size_t mem_guard_violations(void) {
+    return __atomic_load_n(&guard_violations, __ATOMIC_RELAXED);
+}
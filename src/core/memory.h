@@ -0,0 +1,46 @@
+#ifndef CORE_MEMORY_H
+#define CORE_MEMORY_H
+
+#include <stddef.h>
+
+// Tracked heap allocation. Every block carries a small header with its size and tag, so
+// the engine can report per-subsystem usage and catch allocations in the frame loop.
+// Memory from mem_* must be released with mem_free (and vice versa for malloc/free).
+typedef enum {
+    MEM_TAG_ASSETS,
+    MEM_TAG_SCENE,
+    MEM_TAG_RENDERER,
+    MEM_TAG_ARENA,
+    MEM_TAG_JOBS,
+    MEM_TAG_COUNT
+} MemTag;
+
+void* mem_alloc(size_t size, MemTag tag);
+void* mem_calloc(size_t count, size_t size, MemTag tag);
+// Keeps the tag of `ptr`; a NULL ptr allocates under `tag`.
+void* mem_realloc(void* ptr, size_t size, MemTag tag);
+void mem_free(void* ptr);
+
+typedef struct {
+    size_t bytes;        // currently allocated
+    size_t peak_bytes;   // high-water mark of bytes
+    size_t live;         // allocations not freed yet
+    size_t allocations;  // allocation calls so far, reallocs included
+} MemTagStats;
+
+MemTagStats mem_tag_stats(MemTag tag);
+const char* mem_tag_name(MemTag tag);
+
+// Steady-state guard: while armed, every allocation is counted as a violation and the
+// first few are logged with their tag and size. MEM_GUARD_ABORT stops at the first one,
+// for catching the culprit in a debugger.
+typedef enum {
+    MEM_GUARD_OFF,
+    MEM_GUARD_WARN,
+    MEM_GUARD_ABORT
+} MemGuardMode;
+
+void mem_guard_set(MemGuardMode mode);
+size_t mem_guard_violations(void);
+
+#endif // CORE_MEMORY_H
@@ -0,0 +1,169 @@
+#include "occlusion.h"
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+#include "memory.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Rows are padded to a multiple of this so the SIMD loops never need a scalar tail.
+#define OCCLUSION_LANES 8
+
+struct OcclusionBuffer {
+    int width, height, stride;
+    float* depth;
+    ClipDepth clip_depth;
+    OcclusionStats stats;
+};
+
+OcclusionBuffer* occlusion_create(int screen_width, int screen_height, int scale) {
+    if (scale < 1) scale = 1;
+    OcclusionBuffer* ob = mem_alloc(sizeof(OcclusionBuffer), MEM_TAG_SCENE);
+    if (!ob) return NULL;
+    ob->width = (screen_width + scale - 1) / scale;
+    ob->height = (screen_height + scale - 1) / scale;
+    ob->stride = (ob->width + OCCLUSION_LANES - 1) / OCCLUSION_LANES * OCCLUSION_LANES;
+    ob->depth = mem_alloc((size_t)ob->stride * ob->height * sizeof(float), MEM_TAG_SCENE);
+    if (!ob->depth) {
+        mem_free(ob);
+        return NULL;
+    }
+    occlusion_clear(ob, CLIP_DEPTH_STANDARD);
+    return ob;
+}
+
+void occlusion_destroy(OcclusionBuffer* ob) {
+    if (!ob) return;
+    mem_free(ob->depth);
+    mem_free(ob);
+}
+
+void occlusion_clear(OcclusionBuffer* ob, ClipDepth depth) {
+    ob->clip_depth = depth;
+    size_t n = (size_t)ob->stride * ob->height;
+    for (size_t i = 0; i < n; ++i) ob->depth[i] = FLT_MAX;
+    ob->stats = (OcclusionStats){0, 0, 0};
+}
+
+OcclusionStats occlusion_stats(const OcclusionBuffer* ob) {
+    return ob->stats;
+}
+
+// Clip space to buffer texels, with depth in [0, 1] growing with distance in either depth
+// convention; the buffer only needs the ordering.
+static Vec3 clip_to_buffer(const OcclusionBuffer* ob, Vec4 c) {
+    float inv_w = 1.0f / c.w;
+    int reversed = ob->clip_depth == CLIP_DEPTH_REVERSED;
+    return (Vec3){
+        (c.x * inv_w + 1.0f) * 0.5f * (float)ob->width,
+        (1.0f - c.y * inv_w) * 0.5f * (float)ob->height,
+        reversed ? 1.0f - c.z * inv_w : (c.z * inv_w + 1.0f) * 0.5f
+    };
+}
+
+void occlusion_draw_triangle(OcclusionBuffer* ob, Vec4 c0, Vec4 c1, Vec4 c2) {
+    const float w_min = 1e-6f;
+    if (c0.w <= w_min || c1.w <= w_min || c2.w <= w_min) return;
+    Vec3 v[3] = { clip_to_buffer(ob, c0), clip_to_buffer(ob, c1), clip_to_buffer(ob, c2) };
+
+    float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+    if (fabsf(area) < 1e-6f) return;
+    float orient = area > 0.0f ? 1.0f : -1.0f;
+    float z = fmaxf(v[0].z, fmaxf(v[1].z, v[2].z));
+
+    // Edge k runs from v[k] to v[k+1]; E(x, y) = a*x + b*y + c is >= 0 inside. Texels are
+    // sampled at their centres with both sides of a shared edge claiming it, so a mesh
+    // leaves no cracks; the small overreach at silhouettes is absorbed by the one-texel
+    // margin in occlusion_test_aabb.
+    float a[3], b[3], c[3];
+    for (int k = 0; k < 3; ++k) {
+        Vec3 p = v[k], q = v[(k + 1) % 3];
+        a[k] = -(q.y - p.y) * orient;
+        b[k] =  (q.x - p.x) * orient;
+        c[k] = -(a[k] * p.x + b[k] * p.y);
+    }
+
+    int x0 = (int)floorf(fminf(v[0].x, fminf(v[1].x, v[2].x)));
+    int y0 = (int)floorf(fminf(v[0].y, fminf(v[1].y, v[2].y)));
+    int x1 = (int)ceilf(fmaxf(v[0].x, fmaxf(v[1].x, v[2].x)));
+    int y1 = (int)ceilf(fmaxf(v[0].y, fmaxf(v[1].y, v[2].y)));
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > ob->width) x1 = ob->width;
+    if (y1 > ob->height) y1 = ob->height;
+    if (x0 >= x1 || y0 >= y1) return;
+    ob->stats.occluder_triangles++;
+
+    x0 &= ~(OCCLUSION_LANES - 1);
+    for (int y = y0; y < y1; ++y) {
+        float py = (float)y + 0.5f;
+        float* row = &ob->depth[(size_t)y * ob->stride];
+        int x = x0;
+#if defined(__AVX2__)
+        const __m256 lane = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 zv = _mm256_set1_ps(z);
+        for (; x < x1; x += OCCLUSION_LANES) {
+            __m256 px = _mm256_add_ps(_mm256_set1_ps((float)x), lane);
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int k = 0; k < 3; ++k) {
+                __m256 e = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a[k]), px),
+                                         _mm256_set1_ps(b[k] * py + c[k]));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(e, zero, _CMP_GE_OQ));
+            }
+            __m256 d = _mm256_loadu_ps(&row[x]);
+            _mm256_storeu_ps(&row[x], _mm256_blendv_ps(d, _mm256_min_ps(d, zv), inside));
+        }
+#endif
+        for (; x < x1; ++x) {
+            float px = (float)x + 0.5f;
+            if (a[0] * px + (b[0] * py + c[0]) >= 0.0f &&
+                a[1] * px + (b[1] * py + c[1]) >= 0.0f &&
+                a[2] * px + (b[2] * py + c[2]) >= 0.0f && z < row[x])
+                row[x] = z;
+        }
+    }
+}
+
+int occlusion_test_aabb(OcclusionBuffer* ob, Mat4 m, Vec3 mn, Vec3 mx) {
+    __atomic_fetch_add(&ob->stats.tested, 1, __ATOMIC_RELAXED);
+
+    // Screen rect and nearest depth of the box's eight corners. A corner at or behind the
+    // eye means the box may surround the camera: always visible.
+    float sx0 = FLT_MAX, sy0 = FLT_MAX, sx1 = -FLT_MAX, sy1 = -FLT_MAX, z_near = FLT_MAX;
+    for (int i = 0; i < 8; ++i) {
+        Vec3 p = { (i & 1) ? mx.x : mn.x, (i & 2) ? mx.y : mn.y, (i & 4) ? mx.z : mn.z };
+        Vec4 c = mat4_mul_vec4(m, (Vec4){p.x, p.y, p.z, 1.0f});
+        if (c.w <= 1e-6f) return 1;
+        Vec3 s = clip_to_buffer(ob, c);
+        sx0 = fminf(sx0, s.x); sx1 = fmaxf(sx1, s.x);
+        sy0 = fminf(sy0, s.y); sy1 = fmaxf(sy1, s.y);
+        z_near = fminf(z_near, s.z);
+    }
+
+    // One texel of margin covers texels an occluder edge only partly crosses.
+    int x0 = (int)floorf(sx0) - 1, y0 = (int)floorf(sy0) - 1;
+    int x1 = (int)ceilf(sx1) + 1, y1 = (int)ceilf(sy1) + 1;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > ob->width) x1 = ob->width;
+    if (y1 > ob->height) y1 = ob->height;
+    if (x0 >= x1 || y0 >= y1) return 1;
+
+    // Visible as soon as one overlapped texel has nothing in front of the box's nearest point.
+    for (int y = y0; y < y1; ++y) {
+        const float* row = &ob->depth[(size_t)y * ob->stride];
+        int x = x0;
+#if defined(__AVX2__)
+        __m256 zv = _mm256_set1_ps(z_near);
+        for (; x + OCCLUSION_LANES <= x1; x += OCCLUSION_LANES)
+            if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(&row[x]), zv, _CMP_GT_OQ))) return 1;
+#endif
+        for (; x < x1; ++x)
+            if (row[x] > z_near) return 1;
+    }
+
+    __atomic_fetch_add(&ob->stats.culled, 1, __ATOMIC_RELAXED);
+    return 0;
+}
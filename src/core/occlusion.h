@@ -0,0 +1,41 @@
+#ifndef CORE_OCCLUSION_H
+#define CORE_OCCLUSION_H
+
+#include <stddef.h>
+#include "mat.h"
+#include "vec.h"
+#include "clip.h"
+
+// Low-resolution depth buffer for software occlusion culling. A few large occluders are
+// rasterized into it with each triangle writing its farthest depth, so stored depth never
+// claims more than the occluder really hides. Objects whose screen bounds lie behind every
+// texel they overlap are then known to be hidden and can skip transform and raster.
+// Depth is the renderer's: NDC z mapped to [0, 1].
+typedef struct OcclusionBuffer OcclusionBuffer;
+
+// The buffer is 1/scale of the screen in each direction.
+OcclusionBuffer* occlusion_create(int screen_width, int screen_height, int scale);
+void occlusion_destroy(OcclusionBuffer* ob);
+
+// Resets depth to "nothing occludes" and the per-frame counters. Occluders drawn and boxes
+// tested until the next clear are in clip space of the `depth` convention.
+void occlusion_clear(OcclusionBuffer* ob, ClipDepth depth);
+
+// Rasterizes one occluder triangle given in clip space. Triangles crossing the near plane
+// are skipped, which only makes culling less aggressive.
+void occlusion_draw_triangle(OcclusionBuffer* ob, Vec4 c0, Vec4 c1, Vec4 c2);
+
+// Returns 0 if the world-space box is certainly hidden by what was drawn since the last
+// clear, 1 if it may be visible. Every call counts towards the frame's stats. Once drawing
+// is done, any number of threads may test at the same time.
+int occlusion_test_aabb(OcclusionBuffer* ob, Mat4 view_proj, Vec3 min, Vec3 max);
+
+typedef struct {
+    size_t occluder_triangles;
+    size_t tested;
+    size_t culled;
+} OcclusionStats;
+
+OcclusionStats occlusion_stats(const OcclusionBuffer* ob);
+
+#endif // CORE_OCCLUSION_H
@@ -1,27 +1,89 @@
 #include "profiler.h"
 #include <stdio.h>
+#include "core/memory.h"
 
-static double frame_time = 0.0, draw_time = 0.0, present_time = 0.0;
+static double frame_time = 0.0, draw_time = 0.0, raster_wait_time = 0.0, present_time = 0.0;
 static int frame_count = 0;
+static long occlusion_tested = 0, occlusion_culled = 0;
+static JobSystem* job_system = NULL;
+
+#define PROFILER_MAX_WORKERS 64
 
 void profiler_init(void) {
-    frame_time = draw_time = present_time = 0.0;
+    frame_time = draw_time = raster_wait_time = present_time = 0.0;
     frame_count = 0;
+    occlusion_tested = occlusion_culled = 0;
+    job_system = NULL;
 }
 
 void profiler_record_draw(double dt) {
     draw_time += dt;
 }
 
+void profiler_record_raster_wait(double dt) {
+    raster_wait_time += dt;
+}
+
 void profiler_record_present(double dt) {
     present_time += dt;
 }
 
+void profiler_record_occlusion(int tested, int culled) {
+    occlusion_tested += tested;
+    occlusion_culled += culled;
+}
+
+void profiler_set_job_system(JobSystem* jobs) {
+    job_system = jobs;
+    if (jobs) {
+        // Drop whatever accumulated before the first report window.
+        JobWorkerStats stats[PROFILER_MAX_WORKERS];
+        job_system_take_stats(jobs, stats, PROFILER_MAX_WORKERS);
+    }
+}
+
+// One "busy/idle" percentage pair per worker, the non-worker threads last as "ext".
+static void print_job_stats(void) {
+    JobWorkerStats stats[PROFILER_MAX_WORKERS];
+    int n = job_system_take_stats(job_system, stats, PROFILER_MAX_WORKERS);
+    if (n == 0) return;
+
+    unsigned long jobs = 0, steals = 0;
+    printf("[PROFILE] workers busy/idle %%:");
+    for (int i = 0; i < n; ++i) {
+        double total = stats[i].busy_ms + stats[i].idle_ms;
+        double busy = total > 0.0 ? 100.0 * stats[i].busy_ms / total : 0.0;
+        double idle = total > 0.0 ? 100.0 * stats[i].idle_ms / total : 0.0;
+        if (i == n - 1) printf(" ext %.0f/%.0f", busy, idle);
+        else printf(" %.0f/%.0f", busy, idle);
+        jobs += stats[i].jobs;
+        steals += stats[i].steals;
+    }
+    printf(", jobs: %lu (%lu stolen)\n", jobs, steals);
+}
+
+// Live and peak heap per allocation tag, plus steady-state guard hits.
+static void print_memory_stats(void) {
+    printf("[PROFILE] heap MB (live/peak, blocks):");
+    for (int t = 0; t < MEM_TAG_COUNT; ++t) {
+        MemTagStats s = mem_tag_stats((MemTag)t);
+        printf(" %s %.2f/%.2f %zu", mem_tag_name((MemTag)t),
+               (double)s.bytes / (1024.0 * 1024.0), (double)s.peak_bytes / (1024.0 * 1024.0), s.live);
+    }
+    printf(", steady-state allocations: %zu\n", mem_guard_violations());
+}
+
 void profiler_frame_end(void) {
     frame_count++;
     if (frame_count % 300 == 0) {
-        printf("[PROFILE] avg draw: %.4f ms, present: %.4f ms\n",
+        printf("[PROFILE] avg draw: %.4f ms, raster wait: %.4f ms, present: %.4f ms, "
+               "occlusion culled: %.1f/%.1f\n",
                (draw_time / frame_count) * 1000.0,
-               (present_time / frame_count) * 1000.0);
+               (raster_wait_time / frame_count) * 1000.0,
+               (present_time / frame_count) * 1000.0,
+               (double)occlusion_culled / frame_count,
+               (double)occlusion_tested / frame_count);
+        print_job_stats();
+        print_memory_stats();
     }
 }
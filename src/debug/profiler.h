@@ -1,9 +1,16 @@
 #ifndef PROFILER_H
 #define PROFILER_H
 
+#include "core/job_system.h"
+
 void profiler_init(void);
 void profiler_record_draw(double dt);
+// Time the main thread spent blocked on the raster thread finishing the previous frame.
+void profiler_record_raster_wait(double dt);
 void profiler_record_present(double dt);
+void profiler_record_occlusion(int tested, int culled);
+// Adds per-thread busy/idle shares of `jobs` to the periodic report. Not owned.
+void profiler_set_job_system(JobSystem* jobs);
 void profiler_frame_end(void);
 
 #endif // PROFILER_H
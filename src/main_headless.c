@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "renderer/renderer.h"
+#include "renderer/command_buffer.h"
+#include "scene/teapot_renderer.h"
+#include "assets/loader.h"
+#include "assets/model.h"
+#include "core/camera.h"
+#include "core/mat.h"
+
+// Headless driver: orbits a model from the asset pak with no window, display or SDL, and
+// writes the last frame as a PPM.
+// usage: headless [model.obj] [frames] [out.ppm]
+int main(int argc, char** argv) {
+    const char* model = argc > 1 ? argv[1] : "monkey.obj";
+    int frames = argc > 2 ? atoi(argv[2]) : 1;
+    const char* out_path = argc > 3 ? argv[3] : "build/headless.ppm";
+    const int width = 1280, height = 720;
+    if (frames < 1) frames = 1;
+
+    Vec3* vertices = NULL;
+    Face* faces = NULL;
+    size_t vertex_count = 0, face_count = 0;
+    char msg[128] = {0};
+    if (!assets_load_model_from_pak("build/assets.pak", model, &vertices, &faces,
+                                    &vertex_count, &face_count, msg, sizeof(msg))) {
+        fprintf(stderr, "headless: %s\n", msg[0] ? msg : "failed to load model");
+        return 1;
+    }
+    normalize_model(vertices, vertex_count, 1.0f);
+
+    Renderer* renderer = renderer_create(width, height, NULL);
+    TeapotRenderer* mesh = teapot_renderer_create(vertices, faces, vertex_count, face_count);
+    CommandBuffer* commands = command_buffer_create(0);
+    if (!renderer || !mesh || !commands) {
+        fprintf(stderr, "headless: out of memory\n");
+        command_buffer_destroy(commands);
+        teapot_renderer_destroy(mesh);
+        renderer_destroy(renderer);
+        obj_free_mesh(vertices, faces);
+        return 1;
+    }
+
+    Mat4 proj = mat4_perspective(3.14159265f/3.0f, (float)width/height, 0.1f, 100.0f);
+    int ok = 0;
+    Camera cam = camera_create((Vec3){0, 0, 3}, (Vec3){0, 0, 0}, (Vec3){0, 1, 0}, 0.0f, 0.0f);
+    for (int i = 0; i < frames; ++i) {
+        float angle = 6.2831853f * (float)i / (float)frames;
+        cam.position = (Vec3){3.0f * sinf(angle), 0.5f, 3.0f * cosf(angle)};
+        cam.target = (Vec3){0, 0, 0};
+
+        teapot_renderer_update(mesh, mat4_identity(), camera_get_view(&cam), proj, renderer_get_clip_depth(renderer),
+                               cam.position, width, height, NULL);
+        renderer_clear(renderer, 0xFF000000);
+        command_buffer_reset(commands);
+        teapot_renderer_record(mesh, commands, command_sort_key(0, 0.0f), 0);
+        command_buffer_execute(commands, renderer);
+        if (i == frames - 1) ok = renderer_write_ppm(renderer, out_path);
+        renderer_present(renderer);
+    }
+
+    if (ok) printf("headless: wrote %d frame(s) of %s, last one to %s\n", frames, model, out_path);
+    else fprintf(stderr, "headless: could not write %s\n", out_path);
+
+    command_buffer_destroy(commands);
+    teapot_renderer_destroy(mesh);
+    renderer_destroy(renderer);
+    obj_free_mesh(vertices, faces);
+    return ok ? 0 : 1;
+}
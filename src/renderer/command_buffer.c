@@ -0,0 +1,159 @@
+#include "command_buffer.h"
+#include <stdlib.h>
+#include <string.h>
+#include "core/arena.h"
+#include "core/memory.h"
+
+typedef enum {
+    COMMAND_DRAW_INDEXED,
+    COMMAND_DRAW_TRIANGLE_CLIP,
+    COMMAND_DRAW_LINE
+} CommandType;
+
+typedef struct {
+    CommandType type;
+    union {
+        struct {
+            RendererVertexStreams positions;
+            const uint32_t* colors;
+            const uint32_t* indices;
+            size_t index_count;
+            RendererDrawState state;
+        } indexed;
+        struct {
+            Vec4 v[3];
+            uint32_t c[3];
+        } triangle;
+        struct {
+            Vec3 p0, p1;
+            uint32_t color;
+        } line;
+    } as;
+} Command;
+
+// Sorted instead of the commands themselves: small, and the sequence number makes the
+// order total, so equal keys replay in record order whatever qsort does.
+typedef struct {
+    uint64_t key;
+    uint32_t seq;
+} SortEntry;
+
+struct CommandBuffer {
+    Command* commands;
+    SortEntry* order;
+    size_t count, cap;
+    Arena arena;
+};
+
+CommandBuffer* command_buffer_create(size_t arena_size) {
+    CommandBuffer* cb = mem_calloc(1, sizeof(CommandBuffer), MEM_TAG_RENDERER);
+    if (!cb) return NULL;
+    arena_init(&cb->arena, arena_size ? arena_size : 1);
+    return cb;
+}
+
+void command_buffer_destroy(CommandBuffer* cb) {
+    if (!cb) return;
+    mem_free(cb->commands);
+    mem_free(cb->order);
+    arena_free(&cb->arena);
+    mem_free(cb);
+}
+
+void command_buffer_reset(CommandBuffer* cb) {
+    cb->count = 0;
+    arena_reset(&cb->arena);
+}
+
+size_t command_buffer_count(const CommandBuffer* cb) {
+    return cb->count;
+}
+
+void* command_buffer_alloc(CommandBuffer* cb, size_t size, size_t alignment) {
+    return arena_alloc_aligned(&cb->arena, size, alignment);
+}
+
+uint64_t command_sort_key(uint32_t layer, float depth) {
+    // Non-negative floats order the same as their bit patterns.
+    if (!(depth > 0.0f)) depth = 0.0f;
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    return ((uint64_t)layer << 32) | bits;
+}
+
+static Command* push_command(CommandBuffer* cb, uint64_t key, CommandType type) {
+    if (cb->count + 1 > cb->cap) {
+        size_t nc = cb->cap ? cb->cap * 2 : 256;
+        Command* nc_commands = mem_realloc(cb->commands, nc * sizeof(Command), MEM_TAG_RENDERER);
+        if (!nc_commands) return NULL;
+        cb->commands = nc_commands;
+        SortEntry* nc_order = mem_realloc(cb->order, nc * sizeof(SortEntry), MEM_TAG_RENDERER);
+        if (!nc_order) return NULL;
+        cb->order = nc_order;
+        cb->cap = nc;
+    }
+    size_t i = cb->count++;
+    cb->order[i] = (SortEntry){ key, (uint32_t)i };
+    cb->commands[i].type = type;
+    return &cb->commands[i];
+}
+
+int command_buffer_draw_indexed(CommandBuffer* cb, uint64_t key, RendererVertexStreams positions,
+                                const uint32_t* colors, const uint32_t* indices, size_t index_count,
+                                const RendererDrawState* state) {
+    Command* c = push_command(cb, key, COMMAND_DRAW_INDEXED);
+    if (!c) return 0;
+    c->as.indexed.positions = positions;
+    c->as.indexed.colors = colors;
+    c->as.indexed.indices = indices;
+    c->as.indexed.index_count = index_count;
+    if (state) c->as.indexed.state = *state;
+    else memset(&c->as.indexed.state, 0, sizeof(c->as.indexed.state));
+    return 1;
+}
+
+int command_buffer_draw_triangle_clip(CommandBuffer* cb, uint64_t key, Vec4 v0, Vec4 v1, Vec4 v2,
+                                      uint32_t c0, uint32_t c1, uint32_t c2) {
+    Command* c = push_command(cb, key, COMMAND_DRAW_TRIANGLE_CLIP);
+    if (!c) return 0;
+    c->as.triangle.v[0] = v0; c->as.triangle.v[1] = v1; c->as.triangle.v[2] = v2;
+    c->as.triangle.c[0] = c0; c->as.triangle.c[1] = c1; c->as.triangle.c[2] = c2;
+    return 1;
+}
+
+int command_buffer_draw_line(CommandBuffer* cb, uint64_t key, Vec3 p0, Vec3 p1, uint32_t color) {
+    Command* c = push_command(cb, key, COMMAND_DRAW_LINE);
+    if (!c) return 0;
+    c->as.line.p0 = p0;
+    c->as.line.p1 = p1;
+    c->as.line.color = color;
+    return 1;
+}
+
+static int compare_entry(const void* a, const void* b) {
+    const SortEntry* x = a;
+    const SortEntry* y = b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+void command_buffer_execute(CommandBuffer* cb, Renderer* r) {
+    qsort(cb->order, cb->count, sizeof(SortEntry), compare_entry);
+
+    for (size_t i = 0; i < cb->count; ++i) {
+        const Command* c = &cb->commands[cb->order[i].seq];
+        switch (c->type) {
+        case COMMAND_DRAW_INDEXED:
+            renderer_draw_indexed(r, c->as.indexed.positions, c->as.indexed.colors,
+                                  c->as.indexed.indices, c->as.indexed.index_count, &c->as.indexed.state);
+            break;
+        case COMMAND_DRAW_TRIANGLE_CLIP:
+            renderer_draw_triangle_clip(r, c->as.triangle.v[0], c->as.triangle.v[1], c->as.triangle.v[2],
+                                        c->as.triangle.c[0], c->as.triangle.c[1], c->as.triangle.c[2]);
+            break;
+        case COMMAND_DRAW_LINE:
+            renderer_draw_line(r, c->as.line.p0, c->as.line.p1, c->as.line.color);
+            break;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core/vec.h"
+#include "renderer.h"
+
+// A frame's draws, recorded by scene traversal and replayed into the renderer later. Each
+// command carries a 64-bit sort key; execute runs them in key order, ties in record order.
+// Geometry is referenced, not copied: pointers handed to a record call must stay valid
+// until execute. Data built on the fly can live in the buffer's own per-frame arena.
+//
+// Draws are recorded already transformed, as screen-space streams, not as a mesh plus a
+// transform to apply at execute. The renderer stays free of scene types, and vertex
+// transform keeps running on the job system while recording, which the frame pipeline
+// overlaps with the previous frame's rasterization.
+typedef struct CommandBuffer CommandBuffer;
+
+// arena_size is the initial per-frame arena; it grows when a frame needs more. Command
+// records grow as needed too and keep their capacity across resets, so a steady frame
+// does no allocation.
+CommandBuffer* command_buffer_create(size_t arena_size);
+void command_buffer_destroy(CommandBuffer* cb);
+
+// Drops every command and everything allocated from the arena.
+void command_buffer_reset(CommandBuffer* cb);
+size_t command_buffer_count(const CommandBuffer* cb);
+
+// Per-frame storage, released by the next reset. NULL only when out of memory.
+void* command_buffer_alloc(CommandBuffer* cb, size_t size, size_t alignment);
+
+// Layer in the high 32 bits, then a non-negative depth (view distance): lower layers run
+// first, and within a layer nearer draws run first so later ones hit the depth test.
+uint64_t command_sort_key(uint32_t layer, float depth);
+
+// Record calls mirror the renderer's draw calls. They return 0 if the command could not be
+// stored (out of memory); the draw is then lost for this frame.
+int command_buffer_draw_indexed(CommandBuffer* cb, uint64_t key, RendererVertexStreams positions,
+                                const uint32_t* colors, const uint32_t* indices, size_t index_count,
+                                const RendererDrawState* state);
+int command_buffer_draw_triangle_clip(CommandBuffer* cb, uint64_t key, Vec4 v0, Vec4 v1, Vec4 v2,
+                                      uint32_t c0, uint32_t c1, uint32_t c2);
+int command_buffer_draw_line(CommandBuffer* cb, uint64_t key, Vec3 p0, Vec3 p1, uint32_t color);
+
+// Sorts the recorded commands and submits them to r. The buffer keeps its contents; reset
+// it before recording the next frame.
+void command_buffer_execute(CommandBuffer* cb, Renderer* r);
+
+#endif // COMMAND_BUFFER_H
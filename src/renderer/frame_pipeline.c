@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+#include "frame_pipeline.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "core/memory.h"
+#include "core/arena.h"
+
+#define FRAME_PACKET_COUNT 2
+// Ring capacity, a power of two; it never holds more than FRAME_PACKET_COUNT packets.
+#define PACKET_QUEUE_SIZE 4
+
+typedef struct {
+    CommandBuffer* commands;
+} FramePacket;
+
+// Single-producer single-consumer ring. Only the producer writes tail and only the
+// consumer writes head; the release store of an index publishes the slot it covers.
+typedef struct {
+    FramePacket* slots[PACKET_QUEUE_SIZE];
+    unsigned head, tail;
+} PacketQueue;
+
+struct FramePipeline {
+    Renderer* renderer;
+    FramePacket packets[FRAME_PACKET_COUNT];
+    int recording;   // packet the caller records into
+    int in_flight;   // a submitted frame has not been collected by wait yet
+
+    PacketQueue to_raster, to_main;
+    // Count the packets in each queue so an empty side sleeps instead of spinning.
+    sem_t submitted, finished;
+    sem_t ready;  // posted once the raster thread has finished its setup
+    pthread_t thread;
+    int threaded;
+    int shutdown;
+};
+
+static int queue_push(PacketQueue* q, FramePacket* p) {
+    unsigned tail = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    unsigned head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    if (tail - head == PACKET_QUEUE_SIZE) return 0;
+    q->slots[tail % PACKET_QUEUE_SIZE] = p;
+    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static FramePacket* queue_pop(PacketQueue* q) {
+    unsigned head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    unsigned tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    if (head == tail) return NULL;
+    FramePacket* p = q->slots[head % PACKET_QUEUE_SIZE];
+    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+    return p;
+}
+
+static void execute_packet(Renderer* r, FramePacket* p) {
+    command_buffer_execute(p->commands, r);
+    // Only overlays (colour-only) follow before present, so depth can stay in tile scratch.
+    renderer_flush_discard_depth(r);
+}
+
+static void* raster_main(void* arg) {
+    FramePipeline* fp = arg;
+    // Tile jobs run on this thread too while it waits on a flush.
+    arena_thread_scratch();
+    sem_post(&fp->ready);
+    for (;;) {
+        while (sem_wait(&fp->submitted) != 0) {}
+        if (__atomic_load_n(&fp->shutdown, __ATOMIC_ACQUIRE)) break;
+
+        FramePacket* p = queue_pop(&fp->to_raster);
+        if (!p) continue;
+        execute_packet(fp->renderer, p);
+        queue_push(&fp->to_main, p);
+        sem_post(&fp->finished);
+    }
+    return NULL;
+}
+
+FramePipeline* frame_pipeline_create(Renderer* r, size_t arena_size) {
+    FramePipeline* fp = mem_calloc(1, sizeof(FramePipeline), MEM_TAG_RENDERER);
+    if (!fp) return NULL;
+    fp->renderer = r;
+    sem_init(&fp->submitted, 0, 0);
+    sem_init(&fp->finished, 0, 0);
+    sem_init(&fp->ready, 0, 0);
+
+    for (int i = 0; i < FRAME_PACKET_COUNT; ++i) {
+        fp->packets[i].commands = command_buffer_create(arena_size);
+        if (!fp->packets[i].commands) {
+            frame_pipeline_destroy(fp);
+            return NULL;
+        }
+    }
+
+    fp->threaded = pthread_create(&fp->thread, NULL, raster_main, fp) == 0;
+    // Its scratch arena must exist before the caller's first timed frame.
+    if (fp->threaded)
+        while (sem_wait(&fp->ready) != 0) {}
+    return fp;
+}
+
+void frame_pipeline_destroy(FramePipeline* fp) {
+    if (!fp) return;
+    if (fp->threaded) {
+        frame_pipeline_wait(fp);
+        __atomic_store_n(&fp->shutdown, 1, __ATOMIC_RELEASE);
+        sem_post(&fp->submitted);
+        pthread_join(fp->thread, NULL);
+    }
+    sem_destroy(&fp->submitted);
+    sem_destroy(&fp->finished);
+    sem_destroy(&fp->ready);
+    for (int i = 0; i < FRAME_PACKET_COUNT; ++i)
+        command_buffer_destroy(fp->packets[i].commands);
+    mem_free(fp);
+}
+
+CommandBuffer* frame_pipeline_begin(FramePipeline* fp) {
+    CommandBuffer* cb = fp->packets[fp->recording].commands;
+    command_buffer_reset(cb);
+    return cb;
+}
+
+int frame_pipeline_wait(FramePipeline* fp) {
+    if (!fp->in_flight) return 0;
+    if (fp->threaded) {
+        while (sem_wait(&fp->finished) != 0) {}
+        queue_pop(&fp->to_main);
+    }
+    fp->in_flight = 0;
+    return 1;
+}
+
+void frame_pipeline_submit(FramePipeline* fp) {
+    frame_pipeline_wait(fp);
+
+    FramePacket* p = &fp->packets[fp->recording];
+    fp->recording = (fp->recording + 1) % FRAME_PACKET_COUNT;
+    fp->in_flight = 1;
+
+    if (fp->threaded) {
+        // Cannot fail: with one frame in flight the ring is never full.
+        queue_push(&fp->to_raster, p);
+        sem_post(&fp->submitted);
+    } else {
+        execute_packet(fp->renderer, p);
+    }
+}
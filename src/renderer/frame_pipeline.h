@@ -0,0 +1,43 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <stddef.h>
+#include "renderer.h"
+#include "command_buffer.h"
+
+// Two-stage frame pipeline: the calling thread simulates and records frame N+1 while a
+// raster thread executes frame N's command buffer into the renderer. Frames travel as two
+// double-buffered packets (one recording, one in flight) over lock-free single-producer
+// single-consumer queues, so at most one frame is ever in flight.
+//
+// Per frame, on the calling thread:
+//     CommandBuffer* cb = frame_pipeline_begin(fp);
+//     ... scene update and record into cb ...
+//     if (frame_pipeline_wait(fp)) { overlays; renderer_present(r); }
+//     renderer_clear(r, color);
+//     frame_pipeline_submit(fp);
+// Between submit and the next wait the renderer belongs to the raster thread: only touch
+// it after wait returns. Window and present calls therefore all stay on the caller.
+//
+// Anything a recorded frame points to must survive one more update: data the scene
+// rebuilds every update has to be double-buffered.
+typedef struct FramePipeline FramePipeline;
+
+// arena_size is each packet's command buffer arena. If the raster thread cannot be
+// started, frames are executed inline by frame_pipeline_submit instead.
+FramePipeline* frame_pipeline_create(Renderer* r, size_t arena_size);
+// Finishes the frame in flight, if any, and stops the raster thread.
+void frame_pipeline_destroy(FramePipeline* fp);
+
+// Resets and returns the command buffer of the next frame to record.
+CommandBuffer* frame_pipeline_begin(FramePipeline* fp);
+
+// Blocks until the frame in flight has been rasterized. Returns 1 if there was one: it is
+// now complete in the renderer, ready for overlays and present.
+int frame_pipeline_wait(FramePipeline* fp);
+
+// Hands the frame recorded since begin to the raster thread. Waits first if the previous
+// frame is still in flight.
+void frame_pipeline_submit(FramePipeline* fp);
+
+#endif // FRAME_PIPELINE_H
@@ -1,55 +1,214 @@
 #include <math.h>
 #include <float.h>
 #include <stdlib.h>
-#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "renderer.h"
 #include "core/vec.h"
 #include "core/math.h"
+#include "core/clip.h"
+#include "renderer_backend.h"
+#include "core/memory.h"
+#include "core/arena.h"
+
+#define RENDERER_TILE_SIZE 64
+// Granularity of block rasterization and of the Hi-Z buffer; divides RENDERER_TILE_SIZE.
+#define RASTER_BLOCK_SIZE 8
+
+// The tiled layout addresses pixels with shifts and a 3-bit Morton code per axis.
+#if RENDERER_TILE_SIZE != 64 || RASTER_BLOCK_SIZE != 8
+#error "tiled layout expects 64-pixel tiles of 8-pixel blocks"
+#endif
+#define TILE_PIXELS (RENDERER_TILE_SIZE * RENDERER_TILE_SIZE)
+#define BLOCK_PIXELS (RASTER_BLOCK_SIZE * RASTER_BLOCK_SIZE)
+
+// Attribute plane over the screen: value(x, y) = dx * (x - ox) + dy * (y - oy) + c.
+// Planes are anchored at v0 so large screen coordinates don't eat the precision of c.
+typedef struct {
+    float dx, dy, c;
+} RasterPlane;
+
+// Per-triangle setup: clamped bounding box plus the normalized barycentric planes.
+// Everything the inner loops need is computed once here, so the per-pixel work is adds.
+typedef struct {
+    int min_x, min_y, max_x, max_y;
+    float z_min;
+    float ox, oy;
+    RasterPlane w0, w1, w2;
+    RasterPlane z;
+} TriangleSetup;
+
+// Integer edge function over pixel indices: value(x, y) = c + a * x + b * y, sampled at
+// pixel centres in 28.4 sub-pixel units. The top-left bias is folded into c, so a pixel is
+// covered when all three values are >= 0.
+typedef struct {
+    int64_t c, a, b;
+} FixedEdge;
+
+// A fully set-up triangle as it sits in the tile bins.
+typedef struct {
+    TriangleSetup setup;
+    RasterPlane r, g, b;
+    uint32_t color;
+    int shaded;
+    int fixed;           // coverage from `edges` instead of the barycentric planes
+    FixedEdge edges[3];
+} RasterTriangle;
+
+// How the frame's depth buffer holds a pixel.
+typedef enum {
+    DEPTH_STORE_F32,
+    DEPTH_STORE_I32,
+    DEPTH_STORE_U16
+} DepthStore;
+
+// The rasterizer tests depth keys, smaller being nearer in every format, so one less-than
+// test serves them all. Float formats use z itself; REVERSED_F32 negates it at triangle
+// setup, which loses no precision. Integer formats truncate scale * z + bias clamped to
+// [lo, hi], and D32 is offset by -2^31 so its keys compare as signed 32-bit integers.
+typedef struct {
+    DepthStore store;
+    int integer;
+    int negate;
+    float scale, bias, lo, hi;
+    float clear;        // cleared value of float formats
+    int32_t clear_key;  // cleared key of integer formats
+} DepthFormat;
+
+static const DepthFormat depth_formats[] = {
+    [RENDERER_DEPTH_F32]          = { DEPTH_STORE_F32, 0, 0, 0.0f, 0.0f, 0.0f, 0.0f, FLT_MAX, 0 },
+    [RENDERER_DEPTH_REVERSED_F32] = { DEPTH_STORE_F32, 0, 1, 0.0f, 0.0f, 0.0f, 0.0f, FLT_MAX, 0 },
+    [RENDERER_DEPTH_D16]          = { DEPTH_STORE_U16, 1, 0, 65535.0f, 0.0f, 0.0f, 65534.0f, 0.0f, 65535 },
+    [RENDERER_DEPTH_D24]          = { DEPTH_STORE_I32, 1, 0, 16777215.0f, 0.0f, 0.0f, 16777214.0f, 0.0f, 16777215 },
+    [RENDERER_DEPTH_D32]          = { DEPTH_STORE_I32, 1, 0, 4294967296.0f, -2147483648.0f, -2147483648.0f,
+                                      2147483520.0f, 0.0f, INT32_MAX },
+};
+
+// Binned triangles held at once, and triangle indices one tile's bin holds. Both are
+// allocated when binning starts and never grow: a triangle that finds the list or one of its
+// bins full flushes what is binned first, so the frame loop stays off the heap.
+#define RENDERER_BIN_TRIANGLES 8192
+#define RENDERER_BIN_CAPACITY 1024
+
+// Triangle indices touching one tile, in submission order. items points into bin_items.
+typedef struct {
+    uint32_t* items;
+    size_t count;
+} TileBin;
 
 struct Renderer {
     int width, height;
-    uint32_t* framebuffer;
-    float* zbuffer;
-    SDL_Window* sdl_window;
-    SDL_Renderer* sdl_renderer;
-    SDL_Texture* texture;
+    RendererLayout layout;
+    uint32_t* framebuffer;  // where drawing goes: owned_framebuffer, backend memory or tiled_framebuffer
+    uint32_t* owned_framebuffer;
+    uint32_t* tiled_framebuffer;  // TILED only; owned_framebuffer then holds the de-swizzled frame
+    void* zbuffer;          // same layout as framebuffer; TILED pads it to whole tiles
+    RendererDepthFormat depth_format;
+    const DepthFormat* depth;
+
+    // DIRECT frames draw into memory locked from the backend while `locked` is set.
+    RendererBackend* backend;
+    int locked;
+    RendererPresentMode present_mode;
     RendererWindingOrder winding_order;
+    RendererRasterMode raster_mode;
+
+    // Hi-Z: an upper bound on the depth of every RASTER_BLOCK_SIZE square block. Writes only
+    // lower depth, so a stale bound stays safe; blocks written since their bound was taken are
+    // flagged dirty and re-reduced the next time a test needs them.
+    float* hiz;
+    uint8_t* hiz_dirty;
+    int hiz_w, hiz_h;
+
+    // Lazy clear: renderer_clear only records the colour and flags every tile. A tile's
+    // colour and depth are filled the first time something draws into it, and colour still
+    // pending at present is filled then.
+    uint32_t clear_color;
+    uint8_t* tile_pending;
+
+    // Binned (sort-middle) mode: active while a job system with more than one thread is
+    // attached. owns_jobs is set when renderer_set_thread_count created it.
+    JobSystem* jobs;
+    int owns_jobs;
+    int binned;
+    int tiles_x, tiles_y;
+    TileBin* bins;
+    uint32_t* bin_items;  // RENDERER_BIN_CAPACITY per tile, NULL until binning first starts
+    RasterTriangle* tris;  // RENDERER_BIN_TRIANGLES, allocated along with bin_items
+    size_t tri_count;
+
+    // Set for the duration of a flush: tile jobs leave depth in their scratch.
+    int discard_depth;
+
+    uint32_t* resolve_target;  // linear destination of the tile de-swizzle jobs
 };
 
+static int depth_bytes(const Renderer* r) {
+    return r->depth->store == DEPTH_STORE_U16 ? 2 : 4;
+}
+
 Renderer* renderer_create(int width, int height, void* window_handle) {
-    Renderer* r = malloc(sizeof(Renderer));
+    return renderer_create_ex(width, height, window_handle, NULL);
+}
+
+Renderer* renderer_create_ex(int width, int height, void* window_handle, const RendererConfig* config) {
+    const RendererConfig defaults = { RENDERER_LAYOUT_LINEAR, RENDERER_DEPTH_F32 };
+    if (!config) config = &defaults;
+    if ((unsigned)config->depth_format > RENDERER_DEPTH_D32) return NULL;
+
+    Renderer* r = mem_alloc(sizeof(Renderer), MEM_TAG_RENDERER);
     if (!r) return NULL;
 
     r->width = width;
     r->height = height;
-    r->framebuffer = malloc(width * height * sizeof(uint32_t));
-    r->zbuffer = malloc(width * height * sizeof(float));
-    r->sdl_renderer = NULL;
-    r->texture = NULL;
-    r->sdl_window = (SDL_Window*)window_handle;
-    r->winding_order = RENDERER_WINDING_CCW;
+    r->layout = config->layout;
+    r->depth_format = config->depth_format;
+    r->depth = &depth_formats[config->depth_format];
+    r->tiles_x = (width + RENDERER_TILE_SIZE - 1) / RENDERER_TILE_SIZE;
+    r->tiles_y = (height + RENDERER_TILE_SIZE - 1) / RENDERER_TILE_SIZE;
+    size_t pixels = (size_t)width * height;
+    if (r->layout == RENDERER_LAYOUT_TILED) pixels = (size_t)r->tiles_x * r->tiles_y * TILE_PIXELS;
 
-    if (!r->framebuffer || !r->zbuffer) {
-        renderer_destroy(r);
-        return NULL;
-    }
+    r->owned_framebuffer = mem_alloc((size_t)width * height * sizeof(uint32_t), MEM_TAG_RENDERER);
+    r->tiled_framebuffer = NULL;
+    if (r->layout == RENDERER_LAYOUT_TILED)
+        r->tiled_framebuffer = mem_alloc(pixels * sizeof(uint32_t), MEM_TAG_RENDERER);
+    r->framebuffer = r->layout == RENDERER_LAYOUT_TILED ? r->tiled_framebuffer : r->owned_framebuffer;
+    r->zbuffer = mem_alloc(pixels * depth_bytes(r), MEM_TAG_RENDERER);
+    r->backend = NULL;
+    r->locked = 0;
+    r->present_mode = RENDERER_PRESENT_COPY;
+    r->winding_order = RENDERER_WINDING_CCW;
+    r->raster_mode = RENDERER_RASTER_FLOAT;
+    r->jobs = NULL;
+    r->owns_jobs = 0;
+    r->binned = 0;
+    r->bins = mem_calloc((size_t)r->tiles_x * r->tiles_y, sizeof(TileBin), MEM_TAG_RENDERER);
+    r->clear_color = 0;
+    r->tile_pending = mem_calloc((size_t)r->tiles_x * r->tiles_y, sizeof(uint8_t), MEM_TAG_RENDERER);
+    r->hiz_w = (width + RASTER_BLOCK_SIZE - 1) / RASTER_BLOCK_SIZE;
+    r->hiz_h = (height + RASTER_BLOCK_SIZE - 1) / RASTER_BLOCK_SIZE;
+    r->hiz = mem_alloc((size_t)r->hiz_w * r->hiz_h * sizeof(float), MEM_TAG_RENDERER);
+    r->hiz_dirty = mem_calloc((size_t)r->hiz_w * r->hiz_h, sizeof(uint8_t), MEM_TAG_RENDERER);
+    r->bin_items = NULL;
+    r->tris = NULL;
+    r->tri_count = 0;
+    r->discard_depth = 0;
+    r->resolve_target = NULL;
 
-    r->sdl_renderer = SDL_CreateRenderer(r->sdl_window, -1, SDL_RENDERER_ACCELERATED);
-    if (!r->sdl_renderer) {
+    if (!r->owned_framebuffer || !r->framebuffer || !r->zbuffer || !r->bins || !r->tile_pending || !r->hiz || !r->hiz_dirty) {
         renderer_destroy(r);
         return NULL;
     }
 
-    r->texture = SDL_CreateTexture(
-        r->sdl_renderer,
-        SDL_PIXELFORMAT_ARGB8888,
-        SDL_TEXTUREACCESS_STREAMING,
-        width,
-        height
-    );
-
-    if (!r->texture) {
+    r->backend = renderer_backend_create(width, height, window_handle);
+    if (!r->backend) {
         renderer_destroy(r);
         return NULL;
     }
@@ -59,111 +218,1138 @@ Renderer* renderer_create(int width, int height, void* window_handle) {
 
 void renderer_destroy(Renderer* r) {
     if (!r) return;
-    if (r->texture) SDL_DestroyTexture(r->texture);
-    if (r->sdl_renderer) SDL_DestroyRenderer(r->sdl_renderer);
-    free(r->framebuffer);
-    free(r->zbuffer);
-    free(r);
+    renderer_backend_destroy(r->backend);
+    if (r->owns_jobs) job_system_destroy(r->jobs);
+    mem_free(r->bins);
+    mem_free(r->bin_items);
+    mem_free(r->tris);
+    mem_free(r->tile_pending);
+    mem_free(r->owned_framebuffer);
+    mem_free(r->tiled_framebuffer);
+    mem_free(r->zbuffer);
+    mem_free(r->hiz);
+    mem_free(r->hiz_dirty);
+    mem_free(r);
+}
+
+RendererLayout renderer_get_layout(const Renderer* r) {
+    return r ? r->layout : RENDERER_LAYOUT_LINEAR;
+}
+
+RendererDepthFormat renderer_get_depth_format(const Renderer* r) {
+    return r ? r->depth_format : RENDERER_DEPTH_F32;
+}
+
+ClipDepth renderer_get_clip_depth(const Renderer* r) {
+    return r && r->depth->negate ? CLIP_DEPTH_REVERSED : CLIP_DEPTH_STANDARD;
+}
+
+// Colour and depth memory the rasterizer draws into: the renderer's own buffers, or the
+// scratch copy of a single tile. Pixels are addressed in screen coordinates either way.
+// Scratch depth always holds 32-bit keys, so D16 only appears on the frame itself.
+typedef struct {
+    uint32_t* color;
+    void* depth;
+    DepthStore depth_store;
+    const DepthFormat* fmt;
+    RendererLayout layout;
+    int stride;    // LINEAR: pixels per row
+    int tiles_x;   // TILED: tiles per row
+    int x0, y0;    // screen position of the first stored pixel, tile-aligned
+} RasterTarget;
+
+static RasterTarget frame_target(const Renderer* r) {
+    RasterTarget tg = { r->framebuffer, r->zbuffer, r->depth->store, r->depth,
+                        r->layout, r->width, r->tiles_x, 0, 0 };
+    return tg;
+}
+
+// Tile (tx, ty) alone, TILE_PIXELS each of colour and depth, in the frame's layout.
+static RasterTarget tile_target(const Renderer* r, uint32_t* color, void* depth, int tx, int ty) {
+    RasterTarget tg = { color, depth, r->depth->integer ? DEPTH_STORE_I32 : DEPTH_STORE_F32, r->depth,
+                        r->layout, RENDERER_TILE_SIZE, 1,
+                        tx * RENDERER_TILE_SIZE, ty * RENDERER_TILE_SIZE };
+    return tg;
+}
+
+// Spreads the low three bits of v to bits 0, 2 and 4.
+static inline int morton_spread3(int v) {
+    return (v & 1) | ((v & 2) << 1) | ((v & 4) << 2);
+}
+
+// Index of pixel (x, y) in the target's colour and depth. In both layouts the pixels of one
+// RASTER_BLOCK_SIZE-aligned block row are contiguous, and rows of a block are
+// block_row_stride apart.
+static inline int target_index(const RasterTarget* tg, int x, int y) {
+    x -= tg->x0;
+    y -= tg->y0;
+    if (tg->layout == RENDERER_LAYOUT_LINEAR) return y * tg->stride + x;
+    int tile = (y >> 6) * tg->tiles_x + (x >> 6);
+    int block = morton_spread3((x >> 3) & 7) | (morton_spread3((y >> 3) & 7) << 1);
+    return tile * TILE_PIXELS + block * BLOCK_PIXELS + ((y & 7) << 3) + (x & 7);
+}
+
+static inline int block_row_stride(const RasterTarget* tg) {
+    return tg->layout == RENDERER_LAYOUT_LINEAR ? tg->stride : RASTER_BLOCK_SIZE;
+}
+
+// Last pixel, at most x1, of the contiguous run of row pixels starting at x.
+static inline int span_end(const RasterTarget* tg, int x, int x1) {
+    if (tg->layout == RENDERER_LAYOUT_LINEAR) return x1;
+    int end = x | (RASTER_BLOCK_SIZE - 1);
+    return end < x1 ? end : x1;
+}
+
+// Key of depth z before integer truncation. Hi-Z bounds are compared against this.
+static inline float depth_key_bound(const DepthFormat* f, float z) {
+    if (!f->integer) return z;
+    return fminf(fmaxf(z * f->scale + f->bias, f->lo), f->hi);
+}
+
+static inline int32_t depth_key(const DepthFormat* f, float z) {
+    return (int32_t)depth_key_bound(f, z);
+}
+
+// Depth test of one pixel: stores the key of z and returns 1 if it is nearer.
+static inline int depth_test_store(const RasterTarget* tg, int idx, float z) {
+    if (tg->depth_store == DEPTH_STORE_F32) {
+        float* d = tg->depth;
+        if (!(z < d[idx])) return 0;
+        d[idx] = z;
+        return 1;
+    }
+    int32_t k = depth_key(tg->fmt, z);
+    if (tg->depth_store == DEPTH_STORE_I32) {
+        int32_t* d = tg->depth;
+        if (!(k < d[idx])) return 0;
+        d[idx] = k;
+        return 1;
+    }
+    uint16_t* d = tg->depth;
+    if (!(k < d[idx])) return 0;
+    d[idx] = (uint16_t)k;
+    return 1;
+}
+
+// Sets n depth values from index `at` to the cleared value.
+static void depth_fill(void* depth, DepthStore store, const DepthFormat* f, size_t at, size_t n) {
+    if (store == DEPTH_STORE_F32) {
+        float* d = (float*)depth + at;
+        for (size_t i = 0; i < n; i++) d[i] = f->clear;
+    } else if (store == DEPTH_STORE_I32) {
+        int32_t* d = (int32_t*)depth + at;
+        for (size_t i = 0; i < n; i++) d[i] = f->clear_key;
+    } else {
+        uint16_t* d = (uint16_t*)depth + at;
+        for (size_t i = 0; i < n; i++) d[i] = (uint16_t)f->clear_key;
+    }
+}
+
+static void discard_bins(Renderer* r) {
+    for (int i = 0; i < r->tiles_x * r->tiles_y; ++i) r->bins[i].count = 0;
+    r->tri_count = 0;
+}
+
+#define TILE_PENDING_COLOR 1
+#define TILE_PENDING_DEPTH 2
+
+// Fills whichever of `parts` are still pending for the tile.
+static void tile_resolve_clear(Renderer* r, int tile, uint8_t parts) {
+    uint8_t pending = r->tile_pending[tile] & parts;
+    if (!pending) return;
+
+    if (r->layout == RENDERER_LAYOUT_TILED) {
+        // One contiguous run per buffer, padding included.
+        size_t base = (size_t)tile * TILE_PIXELS;
+        if (pending & TILE_PENDING_COLOR)
+            for (size_t i = 0; i < TILE_PIXELS; i++) r->framebuffer[base + i] = r->clear_color;
+        if (pending & TILE_PENDING_DEPTH) depth_fill(r->zbuffer, r->depth->store, r->depth, base, TILE_PIXELS);
+        r->tile_pending[tile] &= (uint8_t)~pending;
+        return;
+    }
+
+    int x0 = (tile % r->tiles_x) * RENDERER_TILE_SIZE;
+    int y0 = (tile / r->tiles_x) * RENDERER_TILE_SIZE;
+    int x1 = x0 + RENDERER_TILE_SIZE < r->width ? x0 + RENDERER_TILE_SIZE : r->width;
+    int y1 = y0 + RENDERER_TILE_SIZE < r->height ? y0 + RENDERER_TILE_SIZE : r->height;
+    for (int y = y0; y < y1; y++) {
+        int base = y * r->width;
+        if (pending & TILE_PENDING_COLOR)
+            for (int x = x0; x < x1; x++) r->framebuffer[base + x] = r->clear_color;
+        if (pending & TILE_PENDING_DEPTH)
+            depth_fill(r->zbuffer, r->depth->store, r->depth, (size_t)base + x0, (size_t)(x1 - x0));
+    }
+    r->tile_pending[tile] &= (uint8_t)~pending;
+}
+
+// Fills `parts` of every tile overlapping the pixel rect [x0, x1] x [y0, y1].
+static void resolve_clear_rect(Renderer* r, int x0, int y0, int x1, int y1, uint8_t parts) {
+    for (int ty = y0 / RENDERER_TILE_SIZE; ty <= y1 / RENDERER_TILE_SIZE; ty++)
+        for (int tx = x0 / RENDERER_TILE_SIZE; tx <= x1 / RENDERER_TILE_SIZE; tx++)
+            tile_resolve_clear(r, ty * r->tiles_x + tx, parts);
+}
+
+// Flags every tile's depth as cleared and resets Hi-Z to match.
+static void reset_depth(Renderer* r) {
+    for (int i = 0; i < r->tiles_x * r->tiles_y; i++) r->tile_pending[i] |= TILE_PENDING_DEPTH;
+    int blocks = r->hiz_w * r->hiz_h;
+    for (int i = 0; i < blocks; i++) r->hiz[i] = FLT_MAX;
+    memset(r->hiz_dirty, 0, (size_t)blocks);
+}
+
+// Points the framebuffer at memory lent by the backend. Its contents are undefined, which is
+// fine right after a clear: every tile is pending and gets filled before it is shown. If
+// the backend has nothing to lend, the frame stays on the owned buffer.
+static void lock_backend_framebuffer(Renderer* r) {
+    uint32_t* pixels = renderer_backend_lock(r->backend);
+    if (!pixels) return;
+    r->framebuffer = pixels;
+    r->locked = 1;
 }
 
 void renderer_clear(Renderer* r, uint32_t color) {
-    int count = r->width * r->height;
-    for (int i = 0; i < count; i++) {
-        r->framebuffer[i] = color;
-        r->zbuffer[i] = FLT_MAX;
+    // Anything still binned would be painted over anyway.
+    discard_bins(r);
+    // Tiled frames are de-swizzled into the backend's memory at present instead.
+    if (r->present_mode == RENDERER_PRESENT_DIRECT && !r->locked && r->layout == RENDERER_LAYOUT_LINEAR)
+        lock_backend_framebuffer(r);
+
+    r->clear_color = color;
+    memset(r->tile_pending, TILE_PENDING_COLOR, (size_t)r->tiles_x * r->tiles_y);
+    reset_depth(r);
+}
+
+// Largest value of a w x h block of float depth with rows `stride` apart.
+static float block_max_f32(const float* depth, int stride, int w, int h) {
+    float m = -FLT_MAX;
+#if defined(__AVX2__)
+    if (w == 8) {
+        __m256 mv = _mm256_set1_ps(-FLT_MAX);
+        for (int y = 0; y < h; y++) mv = _mm256_max_ps(mv, _mm256_loadu_ps(&depth[y * stride]));
+        __m128 v = _mm_max_ps(_mm256_castps256_ps128(mv), _mm256_extractf128_ps(mv, 1));
+        v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+        return _mm_cvtss_f32(v);
+    }
+#endif
+    for (int y = 0; y < h; y++) {
+        const float* row = &depth[y * stride];
+        for (int x = 0; x < w; x++) if (row[x] > m) m = row[x];
+    }
+    return m;
+}
+
+// Same for integer keys, stored 32 or 16 bits wide.
+static int32_t block_max_key(const RasterTarget* tg, int idx, int stride, int w, int h) {
+    int32_t m = INT32_MIN;
+    if (tg->depth_store == DEPTH_STORE_U16) {
+        const uint16_t* depth = (const uint16_t*)tg->depth + idx;
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++) if (depth[y * stride + x] > m) m = depth[y * stride + x];
+        return m;
+    }
+    const int32_t* depth = (const int32_t*)tg->depth + idx;
+#if defined(__AVX2__)
+    if (w == 8) {
+        __m256i mv = _mm256_set1_epi32(INT32_MIN);
+        for (int y = 0; y < h; y++)
+            mv = _mm256_max_epi32(mv, _mm256_loadu_si256((const __m256i*)&depth[y * stride]));
+        __m128i v = _mm_max_epi32(_mm256_castsi256_si128(mv), _mm256_extracti128_si256(mv, 1));
+        v = _mm_max_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_max_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(v);
     }
+#endif
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) if (depth[y * stride + x] > m) m = depth[y * stride + x];
+    return m;
+}
+
+// Current depth bound of block (bx, by), in block units. Dirty blocks are re-reduced from
+// the depth in tg first. Integer keys are rounded up to the next float, so a bound never
+// undercuts its block and compares against depth_key_bound like a key.
+static float hiz_block_max(Renderer* r, const RasterTarget* tg, int bx, int by) {
+    int b = by * r->hiz_w + bx;
+    if (!r->hiz_dirty[b]) return r->hiz[b];
+
+    int x0 = bx * RASTER_BLOCK_SIZE, y0 = by * RASTER_BLOCK_SIZE;
+    int x1 = x0 + RASTER_BLOCK_SIZE < r->width ? x0 + RASTER_BLOCK_SIZE : r->width;
+    int y1 = y0 + RASTER_BLOCK_SIZE < r->height ? y0 + RASTER_BLOCK_SIZE : r->height;
+    int idx = target_index(tg, x0, y0);
+    int stride = block_row_stride(tg);
+    float m;
+    if (tg->depth_store == DEPTH_STORE_F32) {
+        m = block_max_f32((const float*)tg->depth + idx, stride, x1 - x0, y1 - y0);
+    } else {
+        int32_t k = block_max_key(tg, idx, stride, x1 - x0, y1 - y0);
+        m = (float)k;
+        if ((double)m < (double)k) m = nextafterf(m, FLT_MAX);
+    }
+
+    r->hiz[b] = m;
+    r->hiz_dirty[b] = 0;
+    return m;
+}
+
+// Flags every block overlapping the pixel rect [x0, x1] x [y0, y1] as written.
+static void hiz_mark_dirty(Renderer* r, int x0, int y0, int x1, int y1) {
+    for (int by = y0 / RASTER_BLOCK_SIZE; by <= y1 / RASTER_BLOCK_SIZE; by++)
+        for (int bx = x0 / RASTER_BLOCK_SIZE; bx <= x1 / RASTER_BLOCK_SIZE; bx++)
+            r->hiz_dirty[by * r->hiz_w + bx] = 1;
+}
+
+static RasterPlane plane_from_edge(Vec3 a, Vec3 b, float ox, float oy, float inv_area) {
+    // edge(a, b, x, y) = (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x)
+    RasterPlane p;
+    p.dx = -(b.y - a.y) * inv_area;
+    p.dy =  (b.x - a.x) * inv_area;
+    p.c  = ((b.x - a.x) * (oy - a.y) - (b.y - a.y) * (ox - a.x)) * inv_area;
+    return p;
+}
+
+static RasterPlane plane_interp(const TriangleSetup* s, float a0, float a1, float a2) {
+    RasterPlane p;
+    p.dx = a0 * s->w0.dx + a1 * s->w1.dx + a2 * s->w2.dx;
+    p.dy = a0 * s->w0.dy + a1 * s->w1.dy + a2 * s->w2.dy;
+    p.c  = a0 * s->w0.c  + a1 * s->w1.c  + a2 * s->w2.c;
+    return p;
+}
+
+static inline float plane_eval(RasterPlane p, const TriangleSetup* s, float x, float y) {
+    return p.dx * (x - s->ox) + p.dy * (y - s->oy) + p.c;
 }
 
 static float edge(Vec3 a, Vec3 b, float x, float y) {
     return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
 }
 
+// Returns 0 when the triangle is degenerate or its bounding box misses the screen.
+static int triangle_setup(const Renderer* r, Vec3 v0, Vec3 v1, Vec3 v2, TriangleSetup* s) {
+    s->min_x = (int)fmaxf(0.0f, fminf(fminf(v0.x, v1.x), v2.x));
+    s->min_y = (int)fmaxf(0.0f, fminf(fminf(v0.y, v1.y), v2.y));
+    s->max_x = (int)fminf((float)(r->width - 1), fmaxf(fmaxf(v0.x, v1.x), v2.x));
+    s->max_y = (int)fminf((float)(r->height - 1), fmaxf(fmaxf(v0.y, v1.y), v2.y));
+    if (s->min_x > s->max_x || s->min_y > s->max_y) return 0;
+
+    float area = edge(v0, v1, v2.x, v2.y);
+    if (fabsf(area) < 1e-6f) return 0;
+    float inv_area = 1.0f / area;
+
+    // REVERSED_F32 rasterizes -z, so nearer is smaller there too.
+    if (r->depth->negate) {
+        v0.z = -v0.z;
+        v1.z = -v1.z;
+        v2.z = -v2.z;
+    }
+
+    s->ox = v0.x;
+    s->oy = v0.y;
+    s->w0 = plane_from_edge(v1, v2, s->ox, s->oy, inv_area);
+    s->w1 = plane_from_edge(v2, v0, s->ox, s->oy, inv_area);
+    s->w2 = plane_from_edge(v0, v1, s->ox, s->oy, inv_area);
+    s->z  = plane_interp(s, v0.z, v1.z, v2.z);
+    s->z_min = fminf(fminf(v0.z, v1.z), v2.z);
+    return 1;
+}
+
+// Sub-pixel precision of the fixed-point mode: 28.4.
+#define FIXED_SUBPIXEL_BITS 4
+#define FIXED_ONE (1 << FIXED_SUBPIXEL_BITS)
+// Vertices beyond this many pixels from the origin keep the float path; inside it every edge
+// product stays well within 64 bits.
+#define FIXED_MAX_COORD 8388608.0f
+
+static inline int64_t fixed_edge_eval(FixedEdge e, int x, int y) {
+    return e.c + e.a * x + e.b * y;
+}
+
+static FixedEdge fixed_edge(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t orient) {
+    // edge(a, b, p) = (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x), p at pixel centres.
+    const int64_t half = FIXED_ONE / 2;
+    FixedEdge e;
+    e.a = -(by - ay) * FIXED_ONE * orient;
+    e.b =  (bx - ax) * FIXED_ONE * orient;
+    e.c = ((bx - ax) * (half - ay) - (by - ay) * (half - ax)) * orient;
+
+    // Top-left rule: a pixel centre exactly on an edge belongs to the triangle only if the
+    // edge is a left edge (interior to its right) or a horizontal top edge (interior below).
+    int top_left = e.a > 0 || (e.a == 0 && e.b > 0);
+    if (!top_left) e.c -= 1;
+    return e;
+}
+
+// Snaps the vertices to the 28.4 grid in place and builds the integer edges. Returns 0 when
+// the snapped triangle has no area. Vertices too far out leave t->fixed at 0 (float path).
+static int fixed_setup(Vec3* v0, Vec3* v1, Vec3* v2, RasterTriangle* t) {
+    t->fixed = 0;
+    Vec3* v[3] = { v0, v1, v2 };
+    int64_t x[3], y[3];
+    for (int i = 0; i < 3; ++i) {
+        if (!(fabsf(v[i]->x) < FIXED_MAX_COORD && fabsf(v[i]->y) < FIXED_MAX_COORD)) return 1;
+        x[i] = (int64_t)lrintf(v[i]->x * FIXED_ONE);
+        y[i] = (int64_t)lrintf(v[i]->y * FIXED_ONE);
+    }
+
+    int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (area == 0) return 0;
+    int64_t orient = area > 0 ? 1 : -1;
+
+    t->edges[0] = fixed_edge(x[1], y[1], x[2], y[2], orient);
+    t->edges[1] = fixed_edge(x[2], y[2], x[0], y[0], orient);
+    t->edges[2] = fixed_edge(x[0], y[0], x[1], y[1], orient);
+    t->fixed = 1;
+
+    // Attributes interpolate over the snapped positions so they agree with coverage.
+    for (int i = 0; i < 3; ++i) {
+        v[i]->x = (float)x[i] / FIXED_ONE;
+        v[i]->y = (float)y[i] / FIXED_ONE;
+    }
+    return 1;
+}
+
 void renderer_set_winding_order(Renderer* r, RendererWindingOrder order) {
     if (r) r->winding_order = order;
 }
 
-void renderer_draw_triangle(Renderer* r, Vec3 v0, Vec3 v1, Vec3 v2, uint32_t color) {
-    if (r->winding_order == RENDERER_WINDING_CW) {
-        Vec3 tmp = v1; v1 = v2; v2 = tmp;
+void renderer_set_raster_mode(Renderer* r, RendererRasterMode mode) {
+    if (r) r->raster_mode = mode;
+}
+
+RendererRasterMode renderer_get_raster_mode(const Renderer* r) {
+    return r ? r->raster_mode : RENDERER_RASTER_FLOAT;
+}
+
+// Triangles are walked in RASTER_BLOCK_SIZE-aligned blocks (or kernel-wide columns for small
+// rects). Each block or column anchors its stepping at its own origin, which depends only on
+// the pixel grid and the tile-clipped rect, so the binned and immediate paths stay
+// bit-identical. Fixed-point edges are exact integers and need no anchoring at all.
+// Rects up to this many pixels, or shorter than a block, skip block classification: its
+// setup costs more than it saves there.
+#define RASTER_DIRECT_AREA (4 * RASTER_BLOCK_SIZE * RASTER_BLOCK_SIZE)
+
+typedef enum {
+    BLOCK_OUTSIDE,
+    BLOCK_PARTIAL,
+    BLOCK_INSIDE
+} BlockCoverage;
+
+// Offsets from a plane's value at a block's first pixel centre to its minimum and maximum
+// over the block. The plane is linear, so both extremes sit at block corners.
+typedef struct {
+    float lo, hi;
+} BlockEdgeRange;
+
+static BlockEdgeRange block_edge_range(RasterPlane p) {
+    const float span = (float)(RASTER_BLOCK_SIZE - 1);
+    float wx = p.dx * span, wy = p.dy * span;
+    BlockEdgeRange e;
+    e.lo = (wx < 0.0f ? wx : 0.0f) + (wy < 0.0f ? wy : 0.0f);
+    e.hi = (wx > 0.0f ? wx : 0.0f) + (wy > 0.0f ? wy : 0.0f);
+    return e;
+}
+
+static inline BlockCoverage classify_block(float w0, float w1, float w2, const BlockEdgeRange e[3]) {
+    if (w0 + e[0].hi < 0.0f || w1 + e[1].hi < 0.0f || w2 + e[2].hi < 0.0f) return BLOCK_OUTSIDE;
+    if (w0 + e[0].lo >= 0.0f && w1 + e[1].lo >= 0.0f && w2 + e[2].lo >= 0.0f) return BLOCK_INSIDE;
+    return BLOCK_PARTIAL;
+}
+
+// Exact range of a fixed-point edge over the pixels [x0, x1] x [y0, y1].
+static inline void fixed_edge_range(FixedEdge e, int x0, int y0, int x1, int y1, int64_t* lo, int64_t* hi) {
+    int64_t v = fixed_edge_eval(e, x0, y0);
+    int64_t ex = e.a * (x1 - x0), ey = e.b * (y1 - y0);
+    *lo = v + (ex < 0 ? ex : 0) + (ey < 0 ? ey : 0);
+    *hi = v + (ex > 0 ? ex : 0) + (ey > 0 ? ey : 0);
+}
+
+static BlockCoverage classify_block_fixed(const FixedEdge e[3], int bx, int by) {
+    const int span = RASTER_BLOCK_SIZE - 1;
+    BlockCoverage cov = BLOCK_INSIDE;
+    for (int k = 0; k < 3; ++k) {
+        int64_t lo, hi;
+        fixed_edge_range(e[k], bx, by, bx + span, by + span, &lo, &hi);
+        if (hi < 0) return BLOCK_OUTSIDE;
+        if (lo < 0) cov = BLOCK_PARTIAL;
     }
+    return cov;
+}
 
-    int minX = (int)fmaxf(0.0f, fminf(fminf(v0.x, v1.x), v2.x));
-    int minY = (int)fmaxf(0.0f, fminf(fminf(v0.y, v1.y), v2.y));
-    int maxX = (int)fminf((float)(r->width - 1), fmaxf(fmaxf(v0.x, v1.x), v2.x));
-    int maxY = (int)fminf((float)(r->height - 1), fmaxf(fmaxf(v0.y, v1.y), v2.y));
+// raster_block draws pixels of [x0, x1] x [y0, y1] with stepping anchored at (bx, by), the
+// top-left of the rect's block or column. `inside` skips the edge tests for covered blocks.
+// Returns nonzero if any pixel passed the depth test.
+static int raster_block_scalar(const RasterTarget* tg, const RasterTriangle* t, int bx, int by,
+                               int x0, int y0, int x1, int y1, int inside) {
+    const TriangleSetup* s = &t->setup;
 
-    float area = edge(v0, v1, v2.x, v2.y);
-    if (fabsf(area) < 1e-6f) return;
-
-    for (int y = minY; y <= maxY; y++) {
-        for (int x = minX; x <= maxX; x++) {
-            float px = x + 0.5f;
-            float py = y + 0.5f;
-
-            float w0 = edge(v1, v2, px, py) / area;
-            float w1 = edge(v2, v0, px, py) / area;
-            float w2 = 1.0f - w0 - w1;
-
-            if (w0 >= 0 && w1 >= 0 && w2 >= 0) {
-                float z = w0 * v0.z + w1 * v1.z + w2 * v2.z;
-                int idx = y * r->width + x;
-                if (z < r->zbuffer[idx]) {
-                    r->zbuffer[idx] = z;
-                    r->framebuffer[idx] = color;
+    float px = bx + 0.5f;
+    float py = by + 0.5f;
+    float w0_row = plane_eval(s->w0, s, px, py);
+    float w1_row = plane_eval(s->w1, s, px, py);
+    float w2_row = plane_eval(s->w2, s, px, py);
+    float z_row  = plane_eval(s->z,  s, px, py);
+    float r_row = 0.0f, g_row = 0.0f, b_row = 0.0f;
+    if (t->shaded) {
+        r_row = plane_eval(t->r, s, px, py);
+        g_row = plane_eval(t->g, s, px, py);
+        b_row = plane_eval(t->b, s, px, py);
+    }
+
+    // Columns left of x0 are skipped by offsetting each row start, not by stepping through them.
+    float skip = (float)(x0 - bx);
+    uint32_t color = t->color;
+    int written = 0;
+    // The float path never writes t->edges, so the integer steps are only read when fixed.
+    int64_t e0_dx = 0, e1_dx = 0, e2_dx = 0;
+    if (t->fixed) {
+        e0_dx = t->edges[0].a; e1_dx = t->edges[1].a; e2_dx = t->edges[2].a;
+    }
+
+    for (int y = by; y <= y1; y++) {
+        if (y >= y0) {
+            float w0 = w0_row + skip * s->w0.dx, w1 = w1_row + skip * s->w1.dx;
+            float w2 = w2_row + skip * s->w2.dx, z = z_row + skip * s->z.dx;
+            float rf = r_row + skip * t->r.dx, gf = g_row + skip * t->g.dx, bf = b_row + skip * t->b.dx;
+            int64_t e0 = 0, e1 = 0, e2 = 0;
+            if (t->fixed) {
+                e0 = fixed_edge_eval(t->edges[0], x0, y);
+                e1 = fixed_edge_eval(t->edges[1], x0, y);
+                e2 = fixed_edge_eval(t->edges[2], x0, y);
+            }
+
+            // The row is one run in the linear layout and one run per block when tiled.
+            for (int xs = x0; xs <= x1; ) {
+                int xe = span_end(tg, xs, x1);
+                int idx = target_index(tg, xs, y);
+                for (int x = xs; x <= xe; x++, idx++) {
+                    int covered = inside || (t->fixed ? (e0 >= 0 && e1 >= 0 && e2 >= 0)
+                                                      : (w0 >= 0 && w1 >= 0 && w2 >= 0));
+                    if (covered && depth_test_store(tg, idx, z)) {
+                        written = 1;
+                        if (t->shaded) {
+                            uint32_t ri = (uint32_t)clampf(rf, 0.0f, 255.0f);
+                            uint32_t gi = (uint32_t)clampf(gf, 0.0f, 255.0f);
+                            uint32_t bi = (uint32_t)clampf(bf, 0.0f, 255.0f);
+                            color = 0xFF000000 | (ri << 16) | (gi << 8) | bi;
+                        }
+                        tg->color[idx] = color;
+                    }
+                    w0 += s->w0.dx; w1 += s->w1.dx; w2 += s->w2.dx; z += s->z.dx;
+                    rf += t->r.dx; gf += t->g.dx; bf += t->b.dx;
+                    e0 += e0_dx; e1 += e1_dx; e2 += e2_dx;
                 }
+                xs = xe + 1;
             }
         }
+
+        w0_row += s->w0.dy; w1_row += s->w1.dy; w2_row += s->w2.dy; z_row += s->z.dy;
+        r_row += t->r.dy; g_row += t->g.dy; b_row += t->b.dy;
     }
+    return written;
 }
 
-void renderer_draw_triangle_shaded(Renderer* r, Vec3 v0, Vec3 v1, Vec3 v2, uint32_t c0, uint32_t c1, uint32_t c2) {
-    int minX = (int)fmaxf(0.0f, fminf(fminf(v0.x, v1.x), v2.x));
-    int minY = (int)fmaxf(0.0f, fminf(fminf(v0.y, v1.y), v2.y));
-    int maxX = (int)fminf((float)(r->width - 1), fmaxf(fmaxf(v0.x, v1.x), v2.x));
-    int maxY = (int)fminf((float)(r->height - 1), fmaxf(fmaxf(v0.y, v1.y), v2.y));
+#if defined(__AVX2__)
+#define RASTER_COLUMN_WIDTH 8
 
-    float area = edge(v0, v1, v2.x, v2.y);
-    if (fabsf(area) < 1e-6f) return;
+static inline __m256 plane_lanes(float row, float dx, __m256 lane) {
+    return _mm256_add_ps(_mm256_set1_ps(row), _mm256_mul_ps(lane, _mm256_set1_ps(dx)));
+}
 
-    float r0 = (float)((c0 >> 16) & 0xFF);
-    float g0 = (float)((c0 >> 8) & 0xFF);
-    float b0 = (float)(c0 & 0xFF);
+static inline __m256i pack_color8(__m256 rf, __m256 gf, __m256 bf) {
+    const __m256 lo = _mm256_setzero_ps();
+    const __m256 hi = _mm256_set1_ps(255.0f);
+    __m256i ri = _mm256_cvttps_epi32(_mm256_max_ps(_mm256_min_ps(rf, hi), lo));
+    __m256i gi = _mm256_cvttps_epi32(_mm256_max_ps(_mm256_min_ps(gf, hi), lo));
+    __m256i bi = _mm256_cvttps_epi32(_mm256_max_ps(_mm256_min_ps(bf, hi), lo));
+    __m256i c = _mm256_or_si256(_mm256_slli_epi32(ri, 16), _mm256_slli_epi32(gi, 8));
+    return _mm256_or_si256(_mm256_or_si256(c, bi), _mm256_set1_epi32((int)0xFF000000));
+}
 
-    float r1 = (float)((c1 >> 16) & 0xFF);
-    float g1 = (float)((c1 >> 8) & 0xFF);
-    float b1 = (float)(c1 & 0xFF);
+// Integer depth keys of eight z lanes; the same arithmetic as depth_key.
+static inline __m256i depth_key8(const DepthFormat* f, __m256 z) {
+    __m256 k = _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(f->scale)), _mm256_set1_ps(f->bias));
+    k = _mm256_min_ps(_mm256_max_ps(k, _mm256_set1_ps(f->lo)), _mm256_set1_ps(f->hi));
+    return _mm256_cvttps_epi32(k);
+}
+
+// Integer depth of a column row as 32-bit keys: lanes in `first` read at idx, lanes in
+// `second` at idx2, others read 0. `full` means first covers all eight lanes. 16-bit depth
+// has no masked loads, so partial rows go lane by lane.
+static inline __m256i depth_load8(const RasterTarget* tg, int idx, int idx2, __m256i first, __m256i second, int full) {
+    if (tg->depth_store == DEPTH_STORE_I32) {
+        const int32_t* d = tg->depth;
+        __m256i v = _mm256_maskload_epi32(&d[idx], first);
+        if (!_mm256_testz_si256(second, second)) v = _mm256_or_si256(v, _mm256_maskload_epi32(&d[idx2], second));
+        return v;
+    }
+    const uint16_t* d = tg->depth;
+    if (full) return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)&d[idx]));
+    int m1 = _mm256_movemask_ps(_mm256_castsi256_ps(first));
+    int m2 = _mm256_movemask_ps(_mm256_castsi256_ps(second));
+    int32_t lanes[8];
+    for (int k = 0; k < 8; ++k)
+        lanes[k] = (m1 >> k) & 1 ? d[idx + k] : (m2 >> k) & 1 ? d[idx2 + k] : 0;
+    return _mm256_loadu_si256((const __m256i*)lanes);
+}
+
+// Stores the keys of the passing lanes; `old` is what depth_load8 returned for the row.
+static inline void depth_store8(const RasterTarget* tg, int idx, int idx2, __m256i pass1, __m256i pass2,
+                                __m256i key, __m256i old, int full) {
+    if (tg->depth_store == DEPTH_STORE_I32) {
+        int32_t* d = tg->depth;
+        _mm256_maskstore_epi32(&d[idx], pass1, key);
+        if (!_mm256_testz_si256(pass2, pass2)) _mm256_maskstore_epi32(&d[idx2], pass2, key);
+        return;
+    }
+    uint16_t* d = tg->depth;
+    if (full) {
+        // Every lane is inside the rect, so rewriting the failing ones with their old value
+        // touches nothing another tile owns.
+        __m256i v = _mm256_blendv_epi8(old, key, pass1);
+        _mm_storeu_si128((__m128i*)&d[idx], _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+        return;
+    }
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, key);
+    int m1 = _mm256_movemask_ps(_mm256_castsi256_ps(pass1));
+    int m2 = _mm256_movemask_ps(_mm256_castsi256_ps(pass2));
+    for (int k = 0; k < 8; ++k) {
+        if ((m1 >> k) & 1) d[idx + k] = (uint16_t)lanes[k];
+        else if ((m2 >> k) & 1) d[idx2 + k] = (uint16_t)lanes[k];
+    }
+}
 
-    float r2 = (float)((c2 >> 16) & 0xFF);
-    float g2 = (float)((c2 >> 8) & 0xFF);
-    float b2 = (float)(c2 & 0xFF);
+// 8-wide kernel: one block row per iteration. Coverage and the depth test are lane masks,
+// and lanes outside [x0, x1] are dropped by masked loads/stores so nothing outside the
+// rect is read or written. Fully covered blocks skip the edge tests.
+static int raster_block(const RasterTarget* tg, const RasterTriangle* t, int bx, int by,
+                        int x0, int y0, int x1, int y1, int inside) {
+    const TriangleSetup* s = &t->setup;
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i lane_i = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256i minus_one = _mm256_set1_epi32(-1);
 
-    for (int y = minY; y <= maxY; y++) {
-        for (int x = minX; x <= maxX; x++) {
-            float px = x + 0.5f;
-            float py = y + 0.5f;
+    // Fixed-point edges run as 32-bit lanes. Over the area this call walks, an edge that never
+    // goes negative is dropped, and one that crosses it stays within a few block widths of
+    // zero - unless the triangle is huge, which takes the 64-bit scalar kernel instead.
+    __m256i e[3] = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+    __m256i e_dy[3] = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+    if (t->fixed && !inside) {
+        for (int k = 0; k < 3; ++k) {
+            int64_t lo, hi;
+            fixed_edge_range(t->edges[k], bx, by, bx + 7, y1, &lo, &hi);
+            if (hi < 0) return 0;
+            if (lo >= 0) continue;
+            if (lo < INT32_MIN || hi > INT32_MAX)
+                return raster_block_scalar(tg, t, bx, by, x0, y0, x1, y1, inside);
+            int32_t origin = (int32_t)fixed_edge_eval(t->edges[k], bx, by);
+            e[k] = _mm256_add_epi32(_mm256_set1_epi32(origin),
+                                    _mm256_mullo_epi32(lane_i, _mm256_set1_epi32((int32_t)t->edges[k].a)));
+            e_dy[k] = _mm256_set1_epi32((int32_t)t->edges[k].b);
+        }
+    }
 
-            float w0 = edge(v1, v2, px, py) / area;
-            float w1 = edge(v2, v0, px, py) / area;
-            float w2 = 1.0f - w0 - w1;
+    __m256i in_rect = _mm256_and_si256(
+        _mm256_cmpgt_epi32(lane_i, _mm256_set1_epi32(x0 - bx - 1)),
+        _mm256_cmpgt_epi32(_mm256_set1_epi32(x1 - bx + 1), lane_i));
 
-            if (w0 >= 0 && w1 >= 0 && w2 >= 0) {
-                float z = w0 * v0.z + w1 * v1.z + w2 * v2.z;
-                int idx = y * r->width + x;
-                if (z < r->zbuffer[idx]) {
-                    r->zbuffer[idx] = z;
+    // A tiled row is contiguous only up to the next block edge. Columns that start inside a
+    // block spill their last lanes into the next one; those lanes use a second pointer.
+    int split = RASTER_COLUMN_WIDTH;
+    if (tg->layout == RENDERER_LAYOUT_TILED && bx + RASTER_BLOCK_SIZE - (bx & 7) <= x1)
+        split = RASTER_BLOCK_SIZE - (bx & 7);
+    __m256i first = in_rect, second = _mm256_setzero_si256();
+    if (split < RASTER_COLUMN_WIDTH) {
+        __m256i head = _mm256_cmpgt_epi32(_mm256_set1_epi32(split), lane_i);
+        first = _mm256_and_si256(in_rect, head);
+        second = _mm256_andnot_si256(head, in_rect);
+    }
+    int float_depth = tg->depth_store == DEPTH_STORE_F32;
+    int full = _mm256_movemask_ps(_mm256_castsi256_ps(first)) == 0xFF;
 
-                    float rf = w0*r0 + w1*r1 + w2*r2;
-                    float gf = w0*g0 + w1*g1 + w2*g2;
-                    float bf = w0*b0 + w1*b1 + w2*b2;
+    float px = bx + 0.5f;
+    float py = by + 0.5f;
+    __m256 w0 = plane_lanes(plane_eval(s->w0, s, px, py), s->w0.dx, lane);
+    __m256 w1 = plane_lanes(plane_eval(s->w1, s, px, py), s->w1.dx, lane);
+    __m256 w2 = plane_lanes(plane_eval(s->w2, s, px, py), s->w2.dx, lane);
+    __m256 z  = plane_lanes(plane_eval(s->z,  s, px, py), s->z.dx,  lane);
+    __m256 rf = zero, gf = zero, bf = zero;
+    if (t->shaded) {
+        rf = plane_lanes(plane_eval(t->r, s, px, py), t->r.dx, lane);
+        gf = plane_lanes(plane_eval(t->g, s, px, py), t->g.dx, lane);
+        bf = plane_lanes(plane_eval(t->b, s, px, py), t->b.dx, lane);
+    }
+    __m256 w0_dy = _mm256_set1_ps(s->w0.dy), w1_dy = _mm256_set1_ps(s->w1.dy);
+    __m256 w2_dy = _mm256_set1_ps(s->w2.dy), z_dy = _mm256_set1_ps(s->z.dy);
+    __m256 r_dy = _mm256_set1_ps(t->r.dy), g_dy = _mm256_set1_ps(t->g.dy), b_dy = _mm256_set1_ps(t->b.dy);
+    __m256i flat = _mm256_set1_epi32((int)t->color);
+    int written = 0;
 
-                    uint32_t ri = (uint32_t)clampf(rf + 0.5f, 0.0f, 255.0f);
-                    uint32_t gi = (uint32_t)clampf(gf + 0.5f, 0.0f, 255.0f);
-                    uint32_t bi = (uint32_t)clampf(bf + 0.5f, 0.0f, 255.0f);
+    for (int y = by; y <= y1; y++) {
+        if (y >= y0) {
+            __m256 cover = _mm256_castsi256_ps(in_rect);
+            if (t->fixed) {
+                __m256i c = _mm256_and_si256(_mm256_cmpgt_epi32(e[0], minus_one), _mm256_cmpgt_epi32(e[1], minus_one));
+                c = _mm256_and_si256(c, _mm256_cmpgt_epi32(e[2], minus_one));
+                cover = _mm256_and_ps(cover, _mm256_castsi256_ps(c));
+            } else if (!inside) {
+                cover = _mm256_and_ps(cover, _mm256_cmp_ps(w0, zero, _CMP_GE_OQ));
+                cover = _mm256_and_ps(cover, _mm256_cmp_ps(w1, zero, _CMP_GE_OQ));
+                cover = _mm256_and_ps(cover, _mm256_cmp_ps(w2, zero, _CMP_GE_OQ));
+            }
 
-                    r->framebuffer[idx] = 0xFF000000 | (ri << 16) | (gi << 8) | bi;
+            if (_mm256_movemask_ps(cover)) {
+                int idx = target_index(tg, bx, y);
+                int idx2 = split < RASTER_COLUMN_WIDTH ? target_index(tg, bx + split, y) - split : idx;
+                float* fdepth = tg->depth;
+                __m256i pass, key = _mm256_setzero_si256(), old = _mm256_setzero_si256();
+                if (float_depth) {
+                    __m256 depth = _mm256_maskload_ps(&fdepth[idx], first);
+                    if (split < RASTER_COLUMN_WIDTH)
+                        depth = _mm256_or_ps(depth, _mm256_maskload_ps(&fdepth[idx2], second));
+                    pass = _mm256_castps_si256(_mm256_and_ps(cover, _mm256_cmp_ps(z, depth, _CMP_LT_OQ)));
+                } else {
+                    key = depth_key8(tg->fmt, z);
+                    old = depth_load8(tg, idx, idx2, first, second, full);
+                    pass = _mm256_and_si256(_mm256_castps_si256(cover), _mm256_cmpgt_epi32(old, key));
+                }
+                if (!_mm256_testz_si256(pass, pass)) {
+                    written = 1;
+                    __m256i color = t->shaded ? pack_color8(rf, gf, bf) : flat;
+                    __m256i pass1 = _mm256_and_si256(pass, first);
+                    __m256i pass2 = _mm256_and_si256(pass, second);
+                    _mm256_maskstore_epi32((int*)&tg->color[idx], pass1, color);
+                    if (split < RASTER_COLUMN_WIDTH) _mm256_maskstore_epi32((int*)&tg->color[idx2], pass2, color);
+                    if (!float_depth) {
+                        depth_store8(tg, idx, idx2, pass1, pass2, key, old, full);
+                    } else {
+                        _mm256_maskstore_ps(&fdepth[idx], pass1, z);
+                        if (split < RASTER_COLUMN_WIDTH) _mm256_maskstore_ps(&fdepth[idx2], pass2, z);
+                    }
                 }
             }
         }
+
+        w0 = _mm256_add_ps(w0, w0_dy); w1 = _mm256_add_ps(w1, w1_dy);
+        w2 = _mm256_add_ps(w2, w2_dy); z = _mm256_add_ps(z, z_dy);
+        if (t->shaded) {
+            rf = _mm256_add_ps(rf, r_dy); gf = _mm256_add_ps(gf, g_dy); bf = _mm256_add_ps(bf, b_dy);
+        }
+        if (t->fixed) {
+            e[0] = _mm256_add_epi32(e[0], e_dy[0]);
+            e[1] = _mm256_add_epi32(e[1], e_dy[1]);
+            e[2] = _mm256_add_epi32(e[2], e_dy[2]);
+        }
+    }
+    return written;
+}
+#else
+#define RASTER_COLUMN_WIDTH RENDERER_TILE_SIZE
+#define raster_block raster_block_scalar
+#endif
+
+// Rasterizes the part of `t` inside the pixel rect [x0, x1] x [y0, y1]. Edge functions are
+// first evaluated at block corners: blocks entirely outside an edge are skipped, blocks
+// entirely inside all three are filled without per-pixel coverage tests, and only blocks an
+// edge crosses take the fine path.
+static void raster_triangle_rect(Renderer* r, const RasterTarget* tg, const RasterTriangle* t,
+                                 int x0, int y0, int x1, int y1) {
+    const TriangleSetup* s = &t->setup;
+    const int mask = ~(RASTER_BLOCK_SIZE - 1);
+    // Hi-Z holds depth keys; for float formats the key is z itself.
+    float z_min = depth_key_bound(r->depth, s->z_min);
+
+    // Small or flat rects gain nothing from classification: walk them in full-height columns
+    // as wide as the kernel, each anchored at its own origin inside the rect (both paths see
+    // identical rects). The Hi-Z check is coarse here: all overlapped blocks must be behind.
+    if ((x1 - x0 + 1) * (y1 - y0 + 1) <= RASTER_DIRECT_AREA || y1 - y0 < RASTER_BLOCK_SIZE) {
+        int visible = 0;
+        for (int by = y0 / RASTER_BLOCK_SIZE; by <= y1 / RASTER_BLOCK_SIZE && !visible; by++)
+            for (int bx = x0 / RASTER_BLOCK_SIZE; bx <= x1 / RASTER_BLOCK_SIZE && !visible; bx++)
+                visible = z_min < hiz_block_max(r, tg, bx, by);
+        if (!visible) return;
+
+        int written = 0;
+        for (int cx = x0; cx <= x1; cx += RASTER_COLUMN_WIDTH) {
+            int cx1 = cx + RASTER_COLUMN_WIDTH - 1 < x1 ? cx + RASTER_COLUMN_WIDTH - 1 : x1;
+            written |= raster_block(tg, t, cx, y0, cx, y0, cx1, y1, 0);
+        }
+        if (written) hiz_mark_dirty(r, x0, y0, x1, y1);
+        return;
+    }
+
+    const BlockEdgeRange ranges[3] = {
+        block_edge_range(s->w0), block_edge_range(s->w1), block_edge_range(s->w2)
+    };
+    const BlockEdgeRange z_range = block_edge_range(s->z);
+
+    for (int by = y0 & mask; by <= y1; by += RASTER_BLOCK_SIZE) {
+        float py = by + 0.5f;
+        for (int bx = x0 & mask; bx <= x1; bx += RASTER_BLOCK_SIZE) {
+            float px = bx + 0.5f;
+            BlockCoverage cov = t->fixed
+                ? classify_block_fixed(t->edges, bx, by)
+                : classify_block(plane_eval(s->w0, s, px, py),
+                                 plane_eval(s->w1, s, px, py),
+                                 plane_eval(s->w2, s, px, py), ranges);
+            if (cov == BLOCK_OUTSIDE) continue;
+
+            // Nearest depth the triangle can reach in this block: its plane's minimum over the
+            // block corners, but never nearer than its nearest vertex.
+            float z_near = fmaxf(s->z_min, plane_eval(s->z, s, px, py) + z_range.lo);
+            int hx = bx / RASTER_BLOCK_SIZE, hy = by / RASTER_BLOCK_SIZE;
+            if (depth_key_bound(r->depth, z_near) >= hiz_block_max(r, tg, hx, hy)) continue;
+
+            int cx0 = bx > x0 ? bx : x0;
+            int cy0 = by > y0 ? by : y0;
+            int cx1 = bx + RASTER_BLOCK_SIZE - 1 < x1 ? bx + RASTER_BLOCK_SIZE - 1 : x1;
+            int cy1 = by + RASTER_BLOCK_SIZE - 1 < y1 ? by + RASTER_BLOCK_SIZE - 1 : y1;
+            if (raster_block(tg, t, bx, by, cx0, cy0, cx1, cy1, cov == BLOCK_INSIDE))
+                r->hiz_dirty[hy * r->hiz_w + hx] = 1;
+        }
+    }
+}
+
+// Clips the triangle's bounding box to tile (tx, ty) and rasterizes that piece into tg.
+static void raster_triangle_in_tile(Renderer* r, const RasterTarget* tg, const RasterTriangle* t, int tx, int ty) {
+    const TriangleSetup* s = &t->setup;
+    int x0 = tx * RENDERER_TILE_SIZE;
+    int y0 = ty * RENDERER_TILE_SIZE;
+    int x1 = x0 + RENDERER_TILE_SIZE - 1;
+    int y1 = y0 + RENDERER_TILE_SIZE - 1;
+    if (x0 < s->min_x) x0 = s->min_x;
+    if (y0 < s->min_y) y0 = s->min_y;
+    if (x1 > s->max_x) x1 = s->max_x;
+    if (y1 > s->max_y) y1 = s->max_y;
+    raster_triangle_rect(r, tg, t, x0, y0, x1, y1);
+}
+
+// Moves n pixels between a scratch run of 4-byte pixels and a frame run of `bytes`-wide
+// ones. 2-byte frame pixels are D16 depth, widened to 32-bit keys in the scratch.
+static void copy_run(void* frame, void* scratch, size_t n, int bytes, int to_frame) {
+    if (bytes == 4) {
+        if (to_frame) memcpy(frame, scratch, n * 4);
+        else memcpy(scratch, frame, n * 4);
+        return;
+    }
+    uint16_t* f = frame;
+    int32_t* s = scratch;
+    if (to_frame) for (size_t i = 0; i < n; i++) f[i] = (uint16_t)s[i];
+    else for (size_t i = 0; i < n; i++) s[i] = f[i];
+}
+
+// Copies the on-screen part of a tile between one of the frame's buffers (colour or depth,
+// `bytes` per pixel) and its scratch copy, which has the frame's layout.
+static void tile_copy(const Renderer* r, int tile, void* scratch, void* frame, int bytes, int to_frame) {
+    uint8_t* sc = scratch;
+    if (r->layout == RENDERER_LAYOUT_TILED) {
+        copy_run((uint8_t*)frame + (size_t)tile * TILE_PIXELS * bytes, sc, TILE_PIXELS, bytes, to_frame);
+        return;
+    }
+    int x0 = (tile % r->tiles_x) * RENDERER_TILE_SIZE;
+    int y0 = (tile / r->tiles_x) * RENDERER_TILE_SIZE;
+    size_t n = (size_t)(r->width - x0 < RENDERER_TILE_SIZE ? r->width - x0 : RENDERER_TILE_SIZE);
+    int h = r->height - y0 < RENDERER_TILE_SIZE ? r->height - y0 : RENDERER_TILE_SIZE;
+    for (int y = 0; y < h; y++) {
+        uint8_t* row = (uint8_t*)frame + ((size_t)(y0 + y) * r->width + x0) * bytes;
+        copy_run(row, sc + (size_t)y * RENDERER_TILE_SIZE * 4, n, bytes, to_frame);
+    }
+}
+
+// Copies n pixels. With `stream`, aligned runs use non-temporal stores that bypass the
+// cache on their way to memory.
+static void copy_pixels(uint32_t* dst, const uint32_t* src, int n, int stream) {
+    int i = 0;
+#if defined(__SSE2__)
+    if (stream && ((uintptr_t)dst & 15) == 0)
+        for (; i + 4 <= n; i += 4)
+            _mm_stream_si128((__m128i*)&dst[i], _mm_loadu_si128((const __m128i*)&src[i]));
+#else
+    (void)stream;
+#endif
+    memcpy(&dst[i], &src[i], (size_t)(n - i) * sizeof(uint32_t));
+}
+
+// Fills the tile scratch from the frame. Parts still pending a clear take the clear values
+// without reading the frame at all.
+static void tile_load(Renderer* r, int tile, const RasterTarget* tg) {
+    uint8_t pending = r->tile_pending[tile];
+    if (pending & TILE_PENDING_COLOR)
+        for (int i = 0; i < TILE_PIXELS; i++) tg->color[i] = r->clear_color;
+    else
+        tile_copy(r, tile, tg->color, r->framebuffer, 4, 0);
+    if (pending & TILE_PENDING_DEPTH)
+        depth_fill(tg->depth, tg->depth_store, r->depth, 0, TILE_PIXELS);
+    else
+        tile_copy(r, tile, tg->depth, r->zbuffer, depth_bytes(r), 0);
+}
+
+// Resolves the tile scratch to the frame in one pass. The last flush of a DIRECT frame
+// streams its colour past the cache: backend memory is not read again before present. An
+// earlier flush takes ordinary stores, since tile_load reads the tile back from that memory
+// at the next flush, and that readback is slow if the backend mapped it uncached. COPY
+// frames are read again right away by the present copy. Depth is written back only when
+// something after this flush may still test against it.
+static void tile_store(Renderer* r, int tile, const RasterTarget* tg, int keep_depth) {
+    if (r->layout == RENDERER_LAYOUT_TILED) {
+        memcpy(&r->framebuffer[(size_t)tile * TILE_PIXELS], tg->color, (size_t)TILE_PIXELS * sizeof(uint32_t));
+    } else {
+        int stream = r->locked && !keep_depth;
+        int w = r->width - tg->x0 < RENDERER_TILE_SIZE ? r->width - tg->x0 : RENDERER_TILE_SIZE;
+        int h = r->height - tg->y0 < RENDERER_TILE_SIZE ? r->height - tg->y0 : RENDERER_TILE_SIZE;
+        for (int y = 0; y < h; y++)
+            copy_pixels(&r->framebuffer[(size_t)(tg->y0 + y) * r->width + tg->x0],
+                        &tg->color[y * RENDERER_TILE_SIZE], w, stream);
+#if defined(__SSE2__)
+        // Streaming stores are weakly ordered: drain them before the job counts as done.
+        if (stream) _mm_sfence();
+#endif
+    }
+    r->tile_pending[tile] &= (uint8_t)~TILE_PENDING_COLOR;
+    if (keep_depth) {
+        tile_copy(r, tile, tg->depth, r->zbuffer, depth_bytes(r), 1);
+        r->tile_pending[tile] &= (uint8_t)~TILE_PENDING_DEPTH;
+    }
+}
+
+// Draws one tile's bin into a colour/depth copy of the tile taken from this thread's
+// scratch arena, small enough to stay in cache while every triangle lands on it, then
+// resolves it to the frame once.
+static void raster_tile(void* ctx, int tile) {
+    Renderer* r = ctx;
+    TileBin* bin = &r->bins[tile];
+    if (bin->count == 0) return;
+    int tx = tile % r->tiles_x;
+    int ty = tile / r->tiles_x;
+
+    Arena* scratch = arena_thread_scratch();
+    ArenaMarker mark = { NULL, 0 };
+    uint32_t* color = NULL;
+    void* depth = NULL;
+    if (scratch) {
+        mark = arena_save(scratch);
+        color = arena_alloc_aligned(scratch, TILE_PIXELS * sizeof(uint32_t), 64);
+        depth = arena_alloc_aligned(scratch, TILE_PIXELS * sizeof(int32_t), 64);
+    }
+
+    if (color && depth) {
+        RasterTarget tg = tile_target(r, color, depth, tx, ty);
+        tile_load(r, tile, &tg);
+        for (size_t i = 0; i < bin->count; ++i)
+            raster_triangle_in_tile(r, &tg, &r->tris[bin->items[i]], tx, ty);
+        tile_store(r, tile, &tg, !r->discard_depth);
+    } else {
+        // No scratch memory: draw into the frame directly.
+        RasterTarget tg = frame_target(r);
+        tile_resolve_clear(r, tile, TILE_PENDING_COLOR | TILE_PENDING_DEPTH);
+        for (size_t i = 0; i < bin->count; ++i)
+            raster_triangle_in_tile(r, &tg, &r->tris[bin->items[i]], tx, ty);
+    }
+    if (scratch) arena_restore(scratch, mark);
+}
+
+// Allocates the fixed triangle list and bins the first time binning is switched on.
+static int bins_reserve(Renderer* r) {
+    if (r->bin_items) return 1;
+    int tiles = r->tiles_x * r->tiles_y;
+    r->tris = mem_alloc(RENDERER_BIN_TRIANGLES * sizeof(RasterTriangle), MEM_TAG_RENDERER);
+    r->bin_items = mem_alloc((size_t)tiles * RENDERER_BIN_CAPACITY * sizeof(uint32_t), MEM_TAG_RENDERER);
+    if (!r->tris || !r->bin_items) {
+        mem_free(r->tris);
+        mem_free(r->bin_items);
+        r->tris = NULL;
+        r->bin_items = NULL;
+        return 0;
+    }
+    for (int i = 0; i < tiles; ++i) r->bins[i].items = r->bin_items + (size_t)i * RENDERER_BIN_CAPACITY;
+    return 1;
+}
+
+static void bin_triangle(Renderer* r, const RasterTriangle* t) {
+    const TriangleSetup* s = &t->setup;
+    int tx0 = s->min_x / RENDERER_TILE_SIZE, tx1 = s->max_x / RENDERER_TILE_SIZE;
+    int ty0 = s->min_y / RENDERER_TILE_SIZE, ty1 = s->max_y / RENDERER_TILE_SIZE;
+
+    // No room: draw everything binned so far, which empties the list and every bin.
+    int full = r->tri_count == RENDERER_BIN_TRIANGLES;
+    for (int ty = ty0; ty <= ty1 && !full; ty++)
+        for (int tx = tx0; tx <= tx1 && !full; tx++)
+            full = r->bins[ty * r->tiles_x + tx].count == RENDERER_BIN_CAPACITY;
+    if (full) renderer_flush(r);
+
+    uint32_t index = (uint32_t)r->tri_count++;
+    r->tris[index] = *t;
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            TileBin* bin = &r->bins[ty * r->tiles_x + tx];
+            bin->items[bin->count++] = index;
+        }
+    }
+}
+
+static void submit_triangle(Renderer* r, const RasterTriangle* t) {
+    if (r->binned) {
+        bin_triangle(r, t);
+        return;
+    }
+
+    const TriangleSetup* s = &t->setup;
+    RasterTarget tg = frame_target(r);
+    for (int ty = s->min_y / RENDERER_TILE_SIZE; ty <= s->max_y / RENDERER_TILE_SIZE; ty++) {
+        for (int tx = s->min_x / RENDERER_TILE_SIZE; tx <= s->max_x / RENDERER_TILE_SIZE; tx++) {
+            tile_resolve_clear(r, ty * r->tiles_x + tx, TILE_PENDING_COLOR | TILE_PENDING_DEPTH);
+            raster_triangle_in_tile(r, &tg, t, tx, ty);
+        }
+    }
+}
+
+void renderer_flush(Renderer* r) {
+    if (!r || r->tri_count == 0) return;
+    r->discard_depth = 0;
+    job_system_parallel_for(r->jobs, raster_tile, r, r->tiles_x * r->tiles_y, 1);
+    discard_bins(r);
+}
+
+void renderer_flush_discard_depth(Renderer* r) {
+    if (!r) return;
+    if (r->tri_count > 0) {
+        r->discard_depth = 1;
+        job_system_parallel_for(r->jobs, raster_tile, r, r->tiles_x * r->tiles_y, 1);
+        discard_bins(r);
+    }
+    reset_depth(r);
+}
+
+static void attach_jobs(Renderer* r, JobSystem* jobs, int owned) {
+    renderer_flush(r);
+    if (r->owns_jobs) job_system_destroy(r->jobs);
+    r->jobs = jobs;
+    r->owns_jobs = owned;
+    // Without memory for the bins, rasterization stays immediate on the calling thread.
+    r->binned = job_system_thread_count(jobs) > 1 && bins_reserve(r);
+    // The calling thread runs tile jobs while it waits on a flush; give it its scratch
+    // arena now rather than inside a frame. Job workers create their own at start.
+    if (r->binned) arena_thread_scratch();
+}
+
+void renderer_set_thread_count(Renderer* r, int thread_count) {
+    if (!r) return;
+    attach_jobs(r, thread_count > 1 ? job_system_create(thread_count, 0) : NULL, 1);
+}
+
+void renderer_set_job_system(Renderer* r, JobSystem* jobs) {
+    if (!r) return;
+    attach_jobs(r, jobs, 0);
+}
+
+int renderer_get_thread_count(const Renderer* r) {
+    return r ? job_system_thread_count(r->jobs) : 1;
+}
+
+void renderer_set_present_mode(Renderer* r, RendererPresentMode mode) {
+    if (!r || r->present_mode == mode) return;
+    if (r->locked) {
+        // Keep the frame in progress: move it back to the owned buffer before unlocking.
+        renderer_flush(r);
+        memcpy(r->owned_framebuffer, r->framebuffer, (size_t)r->width * r->height * sizeof(uint32_t));
+        renderer_backend_unlock(r->backend);
+        r->framebuffer = r->owned_framebuffer;
+        r->locked = 0;
+    }
+    r->present_mode = mode;
+}
+
+RendererPresentMode renderer_get_present_mode(const Renderer* r) {
+    return r ? r->present_mode : RENDERER_PRESENT_COPY;
+}
+
+static int setup_flat(const Renderer* r, Vec3 v0, Vec3 v1, Vec3 v2, uint32_t color, RasterTriangle* t) {
+    if (r->winding_order == RENDERER_WINDING_CW) {
+        Vec3 tmp = v1; v1 = v2; v2 = tmp;
+    }
+
+    t->fixed = 0;
+    if (r->raster_mode == RENDERER_RASTER_FIXED && !fixed_setup(&v0, &v1, &v2, t)) return 0;
+    if (!triangle_setup(r, v0, v1, v2, &t->setup)) return 0;
+    t->r = t->g = t->b = (RasterPlane){0.0f, 0.0f, 0.0f};
+    t->color = color;
+    t->shaded = 0;
+    return 1;
+}
+
+static int setup_shaded(const Renderer* r, Vec3 v0, Vec3 v1, Vec3 v2, uint32_t c0, uint32_t c1, uint32_t c2,
+                        RasterTriangle* t) {
+    t->fixed = 0;
+    if (r->raster_mode == RENDERER_RASTER_FIXED && !fixed_setup(&v0, &v1, &v2, t)) return 0;
+    if (!triangle_setup(r, v0, v1, v2, &t->setup)) return 0;
+
+    // Channels ride the same barycentric planes as depth; +0.5 rounds on the final truncation.
+    const TriangleSetup* s = &t->setup;
+    t->r = plane_interp(s, (float)((c0 >> 16) & 0xFF), (float)((c1 >> 16) & 0xFF), (float)((c2 >> 16) & 0xFF));
+    t->g = plane_interp(s, (float)((c0 >> 8) & 0xFF),  (float)((c1 >> 8) & 0xFF),  (float)((c2 >> 8) & 0xFF));
+    t->b = plane_interp(s, (float)(c0 & 0xFF),         (float)(c1 & 0xFF),         (float)(c2 & 0xFF));
+    t->r.c += 0.5f; t->g.c += 0.5f; t->b.c += 0.5f;
+    t->color = 0;
+    t->shaded = 1;
+    return 1;
+}
+
+void renderer_draw_triangle(Renderer* r, Vec3 v0, Vec3 v1, Vec3 v2, uint32_t color) {
+    RasterTriangle t;
+    if (setup_flat(r, v0, v1, v2, color, &t)) submit_triangle(r, &t);
+}
+
+void renderer_draw_triangle_shaded(Renderer* r, Vec3 v0, Vec3 v1, Vec3 v2, uint32_t c0, uint32_t c1, uint32_t c2) {
+    RasterTriangle t;
+    if (setup_shaded(r, v0, v1, v2, c0, c1, c2, &t)) submit_triangle(r, &t);
+}
+
+void renderer_draw_indexed(Renderer* r, RendererVertexStreams positions, const uint32_t* colors,
+                           const uint32_t* indices, size_t index_count, const RendererDrawState* state) {
+    const RendererDrawState defaults = { 0.0f, 0, 0, 0 };
+    if (!state) state = &defaults;
+    size_t tri_count = index_count / 3;
+    size_t drawn = 0;
+
+    float min_area2 = 2.0f * state->min_area;
+    for (size_t i = 0; i < tri_count; ++i) {
+        if (state->max_triangles && drawn == state->max_triangles) break;
+        uint32_t i0 = indices[i * 3], i1 = indices[i * 3 + 1], i2 = indices[i * 3 + 2];
+        Vec3 v0 = {positions.x[i0], positions.y[i0], positions.z[i0]};
+        Vec3 v1 = {positions.x[i1], positions.y[i1], positions.z[i1]};
+        Vec3 v2 = {positions.x[i2], positions.y[i2], positions.z[i2]};
+
+        // A non-finite vertex fails this too (the area is NaN or infinite).
+        float area2 = fabsf((v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x));
+        if (!(area2 >= min_area2) || !isfinite(area2)) continue;
+        drawn++;
+
+        if (state->wireframe) {
+            renderer_draw_line(r, v0, v1, 0xFFFFFFFF);
+            renderer_draw_line(r, v1, v2, 0xFFFFFFFF);
+            renderer_draw_line(r, v2, v0, 0xFFFFFFFF);
+            continue;
+        }
+
+        RasterTriangle t;
+        int ok = state->flat ? setup_flat(r, v0, v1, v2, colors[i0], &t)
+                             : setup_shaded(r, v0, v1, v2, colors[i0], colors[i1], colors[i2], &t);
+        if (ok) submit_triangle(r, &t);
+    }
+}
+
+void renderer_draw_triangle_clip(Renderer* r, Vec4 v0, Vec4 v1, Vec4 v2, uint32_t c0, uint32_t c1, uint32_t c2) {
+    ClipVertex in[3] = { {v0, c0}, {v1, c1}, {v2, c2} };
+    ClipVertex poly[CLIP_MAX_VERTICES];
+    ClipDepth depth = renderer_get_clip_depth(r);
+    int n = clip_triangle(in, poly, depth);
+    int flat = c0 == c1 && c1 == c2;
+
+    Vec3 s[CLIP_MAX_VERTICES];
+    for (int i = 0; i < n; ++i) s[i] = clip_to_screen(poly[i].pos, r->width, r->height, depth);
+    for (int i = 1; i + 1 < n; ++i) {
+        if (flat) renderer_draw_triangle(r, s[0], s[i], s[i + 1], c0);
+        else renderer_draw_triangle_shaded(r, s[0], s[i], s[i + 1], poly[0].color, poly[i].color, poly[i + 1].color);
     }
 }
 
@@ -176,13 +1362,16 @@ Vec3 ndc_to_screen(Vec3 v, int width, int height) {
 }
 
 void renderer_draw_line(Renderer* r, Vec3 p0, Vec3 p1, uint32_t color) {
+    renderer_flush(r);
+
     int x0 = (int)clampf(p0.x, 0.0f, r->width-1.0f);
     int y0 = (int)clampf(p0.y, 0.0f, r->height-1.0f);
     int x1 = (int)clampf(p1.x, 0.0f, r->width-1.0f);
     int y1 = (int)clampf(p1.y, 0.0f, r->height-1.0f);
-    float z0 = p0.z;
-    float z1 = p1.z;
+    float z0 = r->depth->negate ? -p0.z : p0.z;
+    float z1 = r->depth->negate ? -p1.z : p1.z;
 
+    RasterTarget tg = frame_target(r);
     int dx = abs(x1 - x0);
     int dy = abs(y1 - y0);
     int sx = x0 < x1 ? 1 : -1;
@@ -194,10 +1383,12 @@ void renderer_draw_line(Renderer* r, Vec3 p0, Vec3 p1, uint32_t color) {
         if (x0 >= 0 && x0 < r->width && y0 >= 0 && y0 < r->height) {
             float t = n > 1 ? (float)i / (float)(n-1) : 0.0f;
             float z = lerpf(z0, z1, t);
-            int idx = y0 * r->width + x0;
-            if (z < r->zbuffer[idx]) {
-                r->zbuffer[idx] = z;
+            int idx = target_index(&tg, x0, y0);
+            tile_resolve_clear(r, (y0 / RENDERER_TILE_SIZE) * r->tiles_x + x0 / RENDERER_TILE_SIZE,
+                               TILE_PENDING_COLOR | TILE_PENDING_DEPTH);
+            if (depth_test_store(&tg, idx, z)) {
                 r->framebuffer[idx] = color;
+                r->hiz_dirty[(y0 / RASTER_BLOCK_SIZE) * r->hiz_w + x0 / RASTER_BLOCK_SIZE] = 1;
             }
         }
         int e2 = err;
@@ -209,6 +1400,7 @@ void renderer_draw_line(Renderer* r, Vec3 p0, Vec3 p1, uint32_t color) {
 void renderer_draw_rect(Renderer* r, int x, int y, int w, int h, uint32_t color) {
     if (!r || !r->framebuffer) return;
     if (w <= 0 || h <= 0) return;
+    renderer_flush(r);
 
     int x0 = x < 0 ? 0 : x;
     int y0 = y < 0 ? 0 : y;
@@ -216,18 +1408,102 @@ void renderer_draw_rect(Renderer* r, int x, int y, int w, int h, uint32_t color)
     int y1 = y + h - 1;
     if (x1 >= r->width) x1 = r->width - 1;
     if (y1 >= r->height) y1 = r->height - 1;
+    if (x0 > x1 || y0 > y1) return;
+    resolve_clear_rect(r, x0, y0, x1, y1, TILE_PENDING_COLOR);
 
+    RasterTarget tg = frame_target(r);
     for (int yy = y0; yy <= y1; ++yy) {
-        int base = yy * r->width;
-        for (int xx = x0; xx <= x1; ++xx) {
-            r->framebuffer[base + xx] = color;
+        for (int xs = x0; xs <= x1; ) {
+            int xe = span_end(&tg, xs, x1);
+            uint32_t* dst = &r->framebuffer[target_index(&tg, xs, yy)];
+            for (int xx = xs; xx <= xe; ++xx) *dst++ = color;
+            xs = xe + 1;
         }
     }
 }
 
+// Copies one tile of the tiled colour buffer into r->resolve_target as linear rows, one
+// block row at a time. A tile still owing its clear gets the clear colour directly.
+static void deswizzle_tile(void* ctx, int tile) {
+    Renderer* r = ctx;
+    int x0 = (tile % r->tiles_x) * RENDERER_TILE_SIZE;
+    int y0 = (tile / r->tiles_x) * RENDERER_TILE_SIZE;
+    int x1 = x0 + RENDERER_TILE_SIZE < r->width ? x0 + RENDERER_TILE_SIZE : r->width;
+    int y1 = y0 + RENDERER_TILE_SIZE < r->height ? y0 + RENDERER_TILE_SIZE : r->height;
+    int pending = r->tile_pending[tile] & TILE_PENDING_COLOR;
+    RasterTarget tg = frame_target(r);
+
+    for (int y = y0; y < y1; y++) {
+        uint32_t* row = &r->resolve_target[(size_t)y * r->width];
+        if (pending) {
+            for (int x = x0; x < x1; x++) row[x] = r->clear_color;
+            continue;
+        }
+        for (int x = x0; x < x1; x += RASTER_BLOCK_SIZE) {
+            int n = x1 - x < RASTER_BLOCK_SIZE ? x1 - x : RASTER_BLOCK_SIZE;
+            memcpy(&row[x], &r->framebuffer[target_index(&tg, x, y)], (size_t)n * sizeof(uint32_t));
+        }
+    }
+}
+
+static void deswizzle_frame(Renderer* r, uint32_t* dst) {
+    r->resolve_target = dst;
+    job_system_parallel_for(r->jobs, deswizzle_tile, r, r->tiles_x * r->tiles_y, 1);
+    r->resolve_target = NULL;
+}
+
 void renderer_present(Renderer* r) {
-    SDL_UpdateTexture(r->texture, NULL, r->framebuffer, r->width * sizeof(uint32_t));
-    SDL_RenderClear(r->sdl_renderer);
-    SDL_RenderCopy(r->sdl_renderer, r->texture, NULL, NULL);
-    SDL_RenderPresent(r->sdl_renderer);
+    renderer_flush_discard_depth(r);
+    if (r->layout == RENDERER_LAYOUT_TILED) {
+        // DIRECT de-swizzles straight into the backend's memory, skipping the upload copy.
+        uint32_t* pixels = r->present_mode == RENDERER_PRESENT_DIRECT ? renderer_backend_lock(r->backend) : NULL;
+        deswizzle_frame(r, pixels ? pixels : r->owned_framebuffer);
+        renderer_backend_present(r->backend, pixels ? NULL : r->owned_framebuffer);
+        return;
+    }
+    // Tiles nothing drew into still owe their clear colour. Their depth stays pending.
+    resolve_clear_rect(r, 0, 0, r->width - 1, r->height - 1, TILE_PENDING_COLOR);
+
+    if (r->locked) {
+        renderer_backend_present(r->backend, NULL);
+        r->framebuffer = r->owned_framebuffer;
+        r->locked = 0;
+    } else {
+        renderer_backend_present(r->backend, r->framebuffer);
+    }
+}
+
+const uint32_t* renderer_get_framebuffer(Renderer* r) {
+    if (!r) return NULL;
+    renderer_flush(r);
+    if (r->layout == RENDERER_LAYOUT_TILED) {
+        deswizzle_frame(r, r->owned_framebuffer);
+        return r->owned_framebuffer;
+    }
+    resolve_clear_rect(r, 0, 0, r->width - 1, r->height - 1, TILE_PENDING_COLOR);
+    return r->framebuffer;
+}
+
+int renderer_write_ppm(Renderer* r, const char* path) {
+    const uint32_t* pixels = renderer_get_framebuffer(r);
+    if (!pixels) return 0;
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return 0;
+
+    fprintf(f, "P6\n%d %d\n255\n", r->width, r->height);
+    unsigned char* row = mem_alloc((size_t)r->width * 3, MEM_TAG_RENDERER);
+    int ok = row != NULL;
+    for (int y = 0; ok && y < r->height; ++y) {
+        const uint32_t* src = &pixels[y * r->width];
+        for (int x = 0; x < r->width; ++x) {
+            row[x * 3 + 0] = (unsigned char)(src[x] >> 16);
+            row[x * 3 + 1] = (unsigned char)(src[x] >> 8);
+            row[x * 3 + 2] = (unsigned char)src[x];
+        }
+        ok = fwrite(row, 3, (size_t)r->width, f) == (size_t)r->width;
+    }
+    mem_free(row);
+    if (fclose(f) != 0) ok = 0;
+    return ok;
 }
@@ -1,25 +1,143 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include "core/vec.h"
+#include "core/clip.h"
+#include "core/job_system.h"
 
 typedef enum {
     RENDERER_WINDING_CCW = 0,
     RENDERER_WINDING_CW  = 1
 } RendererWindingOrder;
 
+// FLOAT tests coverage on float barycentrics (pixels on shared edges may be drawn twice).
+// FIXED snaps vertices to 28.4 sub-pixel fixed point and uses integer edge functions with a
+// top-left fill rule, so pixels on shared edges are covered exactly once.
+typedef enum {
+    RENDERER_RASTER_FLOAT = 0,
+    RENDERER_RASTER_FIXED = 1
+} RendererRasterMode;
+
+// COPY draws into a renderer-owned framebuffer and uploads it at present. DIRECT draws
+// straight into a locked streaming texture (double-buffered) and skips the upload. DIRECT
+// frames must begin with renderer_clear; a frame drawn without one falls back to COPY.
+// Tiles a binned flush leaves in the texture are read back by the next flush that draws into
+// them, which is slow where the backend maps it uncached; DIRECT frames do best flushing once.
+typedef enum {
+    RENDERER_PRESENT_COPY   = 0,
+    RENDERER_PRESENT_DIRECT = 1
+} RendererPresentMode;
+
+// Memory layout of the colour and depth buffers. LINEAR is plain row-major. TILED keeps
+// every 8x8 pixel block contiguous (its rows back to back), orders the blocks of each 64x64
+// tile along a Morton curve and stores the tiles one after another, so the rasterizer's
+// reads and writes for a block stay within four cache lines and a tile within 16 KB. TILED
+// colour is de-swizzled into rows once per frame, at present or readback.
+typedef enum {
+    RENDERER_LAYOUT_LINEAR = 0,
+    RENDERER_LAYOUT_TILED  = 1
+} RendererLayout;
+
+// Depth buffer format. F32 stores z as a float. REVERSED_F32 takes reversed depth - 1 at
+// the near plane, 0 at the far one, as mat4_perspective_reversed in CLIP_DEPTH_REVERSED
+// produces - which spends float precision evenly over distance instead of crowding it near
+// the camera. It stores that depth negated, so smaller is nearer there as in every other
+// format, and clears to FLT_MAX so a fragment on the far plane (-0) still passes. D16, D24
+// and D32 quantize z to unsigned integers of that many bits (D24 in 32-bit words) and test
+// with integer compares; D16 halves depth memory traffic. z is interpolated in single
+// precision, so D32 resolves no finer than a float would.
+typedef enum {
+    RENDERER_DEPTH_F32          = 0,
+    RENDERER_DEPTH_REVERSED_F32 = 1,
+    RENDERER_DEPTH_D16          = 2,
+    RENDERER_DEPTH_D24          = 3,
+    RENDERER_DEPTH_D32          = 4
+} RendererDepthFormat;
+
+// Options fixed for the lifetime of a renderer. A zeroed config gives the defaults.
+typedef struct {
+    RendererLayout layout;
+    RendererDepthFormat depth_format;
+} RendererConfig;
+
 typedef struct Renderer Renderer;
 
+// window_handle is the SDL_Window to present into. Headless builds (renderer_headless.c
+// linked instead of renderer_sdl.c) ignore it and keep frames in memory; pass NULL there.
 Renderer* renderer_create(int width, int height, void* window_handle);
+// Same with explicit options; config may be NULL.
+Renderer* renderer_create_ex(int width, int height, void* window_handle, const RendererConfig* config);
 void renderer_destroy(Renderer* r);
 
+RendererLayout renderer_get_layout(const Renderer* r);
+RendererDepthFormat renderer_get_depth_format(const Renderer* r);
+// Clip-space depth convention the depth format expects: REVERSED for REVERSED_F32,
+// STANDARD otherwise. renderer_draw_triangle_clip clips in it; projections, culling and
+// clipping done for this renderer elsewhere must use it too.
+ClipDepth renderer_get_clip_depth(const Renderer* r);
+
 void renderer_set_winding_order(Renderer* r, RendererWindingOrder order);
+void renderer_set_raster_mode(Renderer* r, RendererRasterMode mode);
+RendererRasterMode renderer_get_raster_mode(const Renderer* r);
+
+// thread_count > 1 switches to binned rasterization: triangles are sorted into screen
+// tiles and rasterized as jobs on thread_count threads at the next flush.
+// Output is bit-identical to the immediate (single-threaded) path.
+void renderer_set_thread_count(Renderer* r, int thread_count);
+// Same, but rasterizes on a job system shared with the rest of the engine; the renderer
+// does not take ownership. NULL goes back to the immediate path.
+void renderer_set_job_system(Renderer* r, JobSystem* jobs);
+int renderer_get_thread_count(const Renderer* r);
+
+// Rasterizes pending binned triangles. Present and the line/rect calls flush on their own.
+// Binned tiles are drawn into a cache-sized scratch copy and resolved to the frame once.
+void renderer_flush(Renderer* r);
+// The last flush of a frame: tiles resolve their colour but never write depth back, and
+// the whole depth buffer then reads as cleared. Only colour-only draws (rects) should
+// follow before the next clear. renderer_present flushes this way.
+void renderer_flush_discard_depth(Renderer* r);
+
+void renderer_set_present_mode(Renderer* r, RendererPresentMode mode);
+RendererPresentMode renderer_get_present_mode(const Renderer* r);
+
 void renderer_clear(Renderer* r, uint32_t color);
 void renderer_present(Renderer* r);
 
+// Finishes pending work and returns the current frame: width * height ARGB pixels, rows
+// tightly packed. Valid until the next clear or present.
+const uint32_t* renderer_get_framebuffer(Renderer* r);
+// Writes the current frame as a binary PPM. Returns 1 on success, 0 on failure.
+int renderer_write_ppm(Renderer* r, const char* path);
+
 void renderer_draw_triangle(Renderer* r, Vec3 v0, Vec3 v1, Vec3 v2, uint32_t color);
 void renderer_draw_triangle_shaded(Renderer* r, Vec3 v0, Vec3 v1, Vec3 v2, uint32_t c0, uint32_t c1, uint32_t c2);
+// Takes clip-space vertices in renderer_get_clip_depth's convention and clips against the
+// near plane and the guard band before drawing, so triangles reaching behind the camera or
+// far off-screen still rasterize only their visible part. Flat when all three colours match.
+void renderer_draw_triangle_clip(Renderer* r, Vec4 v0, Vec4 v1, Vec4 v2, uint32_t c0, uint32_t c1, uint32_t c2);
+
+// Screen-space vertex positions as parallel streams: pixels in x and y, depth in [0, 1] in z.
+typedef struct {
+    const float* x;
+    const float* y;
+    const float* z;
+} RendererVertexStreams;
+
+typedef struct {
+    float min_area;        // skip triangles covering less than this many pixels
+    size_t max_triangles;  // stop after drawing this many, culled ones not counted; 0 for all
+    int flat;              // one colour per triangle, taken from its first vertex
+    int wireframe;         // outline every triangle in white instead of filling it
+} RendererDrawState;
+
+// Draws index_count / 3 triangles from shared vertex streams with per-vertex ARGB colours,
+// Gouraud shaded unless state asks for flat. Triangles touching a non-finite position are
+// skipped, so callers can mark vertices that need clipping with INFINITY and draw those
+// through renderer_draw_triangle_clip. state may be NULL.
+void renderer_draw_indexed(Renderer* r, RendererVertexStreams positions, const uint32_t* colors,
+                           const uint32_t* indices, size_t index_count, const RendererDrawState* state);
 void renderer_draw_line(Renderer* r, Vec3 v0, Vec3 v1, uint32_t color);
 void renderer_draw_rect(Renderer* r, int x, int y, int w, int h, uint32_t color);
 
@@ -0,0 +1,23 @@
+#ifndef RENDERER_BACKEND_H
+#define RENDERER_BACKEND_H
+
+#include <stdint.h>
+
+// Where finished frames go. The rasterizer in renderer.c only ever talks to this interface;
+// renderer_sdl.c shows frames in a window and renderer_headless.c keeps them in memory.
+// Exactly one backend is linked into a build.
+typedef struct RendererBackend RendererBackend;
+
+RendererBackend* renderer_backend_create(int width, int height, void* window_handle);
+void renderer_backend_destroy(RendererBackend* b);
+
+// Lends writable memory for the next frame, width * height pixels with no row padding, or
+// returns NULL if the backend cannot. Contents are undefined. The loan ends with
+// renderer_backend_present(b, NULL) or renderer_backend_unlock.
+uint32_t* renderer_backend_lock(RendererBackend* b);
+void renderer_backend_unlock(RendererBackend* b);
+
+// Shows `pixels` (width * height, tightly packed), or the locked memory when NULL.
+void renderer_backend_present(RendererBackend* b, const uint32_t* pixels);
+
+#endif // RENDERER_BACKEND_H
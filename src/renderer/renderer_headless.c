@@ -0,0 +1,38 @@
+#include <stdlib.h>
+
+#include "renderer_backend.h"
+#include "core/memory.h"
+
+// Memory-only backend: nothing is shown, frames stay in the renderer's own framebuffer where
+// renderer_get_framebuffer and renderer_write_ppm read them. Needs no window or display.
+struct RendererBackend {
+    int width, height;
+};
+
+RendererBackend* renderer_backend_create(int width, int height, void* window_handle) {
+    (void)window_handle;
+    RendererBackend* b = mem_alloc(sizeof(RendererBackend), MEM_TAG_RENDERER);
+    if (!b) return NULL;
+    b->width = width;
+    b->height = height;
+    return b;
+}
+
+void renderer_backend_destroy(RendererBackend* b) {
+    mem_free(b);
+}
+
+uint32_t* renderer_backend_lock(RendererBackend* b) {
+    // There is no other memory to lend; DIRECT frames keep drawing into the owned buffer.
+    (void)b;
+    return NULL;
+}
+
+void renderer_backend_unlock(RendererBackend* b) {
+    (void)b;
+}
+
+void renderer_backend_present(RendererBackend* b, const uint32_t* pixels) {
+    (void)b;
+    (void)pixels;
+}
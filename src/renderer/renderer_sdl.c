@@ -0,0 +1,96 @@
+#include <stdlib.h>
+#include <SDL2/SDL.h>
+
+#include "renderer_backend.h"
+#include "core/memory.h"
+
+// Two streaming textures: copied frames go through textures[0], locked frames alternate
+// between both so the texture being shown is never the one being written.
+struct RendererBackend {
+    int width, height;
+    SDL_Window* sdl_window;
+    SDL_Renderer* sdl_renderer;
+    SDL_Texture* textures[2];
+    int back;
+    int locked;
+};
+
+RendererBackend* renderer_backend_create(int width, int height, void* window_handle) {
+    RendererBackend* b = mem_alloc(sizeof(RendererBackend), MEM_TAG_RENDERER);
+    if (!b) return NULL;
+
+    b->width = width;
+    b->height = height;
+    b->sdl_window = (SDL_Window*)window_handle;
+    b->textures[0] = b->textures[1] = NULL;
+    b->back = 0;
+    b->locked = 0;
+
+    b->sdl_renderer = SDL_CreateRenderer(b->sdl_window, -1, SDL_RENDERER_ACCELERATED);
+    if (!b->sdl_renderer) {
+        renderer_backend_destroy(b);
+        return NULL;
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        b->textures[i] = SDL_CreateTexture(
+            b->sdl_renderer,
+            SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_STREAMING,
+            width,
+            height
+        );
+
+        if (!b->textures[i]) {
+            renderer_backend_destroy(b);
+            return NULL;
+        }
+    }
+
+    return b;
+}
+
+void renderer_backend_destroy(RendererBackend* b) {
+    if (!b) return;
+    renderer_backend_unlock(b);
+    for (int i = 0; i < 2; ++i)
+        if (b->textures[i]) SDL_DestroyTexture(b->textures[i]);
+    if (b->sdl_renderer) SDL_DestroyRenderer(b->sdl_renderer);
+    mem_free(b);
+}
+
+uint32_t* renderer_backend_lock(RendererBackend* b) {
+    void* pixels;
+    int pitch;
+    if (b->locked) return NULL;
+    if (SDL_LockTexture(b->textures[b->back], NULL, &pixels, &pitch) != 0) return NULL;
+
+    // Padded rows cannot be drawn into directly; that frame goes through the copy path.
+    if (pitch != b->width * (int)sizeof(uint32_t)) {
+        SDL_UnlockTexture(b->textures[b->back]);
+        return NULL;
+    }
+    b->locked = 1;
+    return pixels;
+}
+
+void renderer_backend_unlock(RendererBackend* b) {
+    if (!b->locked) return;
+    SDL_UnlockTexture(b->textures[b->back]);
+    b->locked = 0;
+}
+
+void renderer_backend_present(RendererBackend* b, const uint32_t* pixels) {
+    SDL_Texture* texture = b->textures[0];
+    if (!pixels) {
+        texture = b->textures[b->back];
+        renderer_backend_unlock(b);
+        b->back ^= 1;
+    } else {
+        SDL_UpdateTexture(texture, NULL, pixels, b->width * sizeof(uint32_t));
+    }
+
+    SDL_RenderClear(b->sdl_renderer);
+    SDL_RenderCopy(b->sdl_renderer, texture, NULL, NULL);
+    SDL_RenderPresent(b->sdl_renderer);
+}
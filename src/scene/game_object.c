@@ -1,8 +1,9 @@
 #include "game_object.h"
 #include <stdlib.h>
+#include "core/memory.h"
 
-GameObject* game_object_create_mesh(TeapotRenderer* mesh, Mat4 model) {
-    GameObject* go = malloc(sizeof(GameObject));
+GameObject* game_object_create_mesh(const Mesh* mesh, Mat4 model) {
+    GameObject* go = mem_calloc(1, sizeof(GameObject), MEM_TAG_SCENE);
     if (!go) return NULL;
     go->type = GO_TYPE_MESH;
     go->model = model;
@@ -13,5 +14,5 @@ GameObject* game_object_create_mesh(TeapotRenderer* mesh, Mat4 model) {
 
 void game_object_destroy(GameObject* go) {
     if (!go) return;
-    free(go);
+    mem_free(go);
 }
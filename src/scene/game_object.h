@@ -2,7 +2,7 @@
 #define GAME_OBJECT_H
 
 #include "core/mat.h"
-#include "scene/teapot_renderer.h"
+#include "scene/mesh.h"
 
 typedef struct GameObject GameObject;
 
@@ -13,11 +13,13 @@ typedef enum {
 struct GameObject {
     GameObjectType type;
     Mat4 model;
-    TeapotRenderer* mesh;
+    const Mesh* mesh;       // shared; not owned by the object
+    MeshInstance instance;  // this object's transformed copy, rebuilt every update
     int visible;
+    int occluder;           // drawn into the occlusion buffer; never occlusion-tested itself
 };
 
-GameObject* game_object_create_mesh(TeapotRenderer* mesh, Mat4 model);
+GameObject* game_object_create_mesh(const Mesh* mesh, Mat4 model);
 void game_object_destroy(GameObject* go);
 
 #endif // GAME_OBJECT_H
@@ -1,14 +1,24 @@
 #include "game_scene.h"
 #include "scene/game_object.h"
+#include "scene/ground_grid.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <SDL2/SDL.h>
 #include "core/mat.h"
 #include "core/camera.h"
-#include "core/geom.h"
+#include "core/bvh.h"
+#include "core/occlusion.h"
 #include "renderer/renderer.h"
 #include "core/math.h"
+#include "debug/profiler.h"
+#include "core/memory.h"
+
+// Draw order: the ground first, then objects front to back.
+enum { LAYER_GROUND, LAYER_OBJECTS };
+
+// Occlusion buffer texels per screen pixel, per axis.
+#define OCCLUSION_SCALE 4
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -28,13 +38,31 @@ typedef struct {
     size_t player_vcount;
     size_t player_fcount;
 
-    TeapotRenderer* player_renderer;
-    TeapotRenderer* ground_renderer;
+    Mesh* player_mesh;
+    Mesh* ground_mesh;
+
+    // BVH over object bounds (leaf user value = object index), refit as objects move.
+    // in_view holds the objects inside the frustum at the last update, in index order;
+    // update and render only walk that list.
+    Bvh* bvh;
+    int* proxies;
+    uint32_t* in_view;
+    size_t in_view_count;
+
+    // Quarter-resolution depth of the occluder objects, rebuilt each update. Other objects
+    // in view whose box is behind it skip transform and draw entirely. The box tests run
+    // as jobs; unoccluded[k] is the verdict for in_view[k].
+    OcclusionBuffer* occlusion;
+    unsigned char* unoccluded;
 
     Mat4 proj, view;
+    ClipDepth depth;  // convention of proj
     Vec3 camera_pos;
     int width, height;
 
+    // Shared job system for occlusion tests and vertex transforms; not owned, may be NULL.
+    JobSystem* jobs;
+
     size_t player_index;
     float player_speed;
     float player_yaw;
@@ -47,8 +75,8 @@ typedef struct {
 static void make_plane(Vec3** v, Face** f, size_t* vc, size_t* fc, float w, float d, float y) {
     *vc = 4;
     *fc = 2;
-    *v = malloc(sizeof(Vec3) * 4);
-    *f = malloc(sizeof(Face) * 2);
+    *v = mem_alloc(sizeof(Vec3) * 4, MEM_TAG_SCENE);
+    *f = mem_alloc(sizeof(Face) * 2, MEM_TAG_SCENE);
 
     (*v)[0] = (Vec3){-w/2, y, -d/2};
     (*v)[1] = (Vec3){ w/2, y, -d/2};
@@ -59,27 +87,58 @@ static void make_plane(Vec3** v, Face** f, size_t* vc, size_t* fc, float w, floa
     (*f)[1] = (Face){0,2,3};
 }
 
+static void object_bounds(const GameObject* go, Vec3* min, Vec3* max) {
+    Vec3 c;
+    float r;
+    mesh_world_sphere(go->mesh, go->model, &c, &r);
+    *min = (Vec3){c.x - r, c.y - r, c.z - r};
+    *max = (Vec3){c.x + r, c.y + r, c.z + r};
+}
+
+typedef struct {
+    GameSceneData* d;
+    Mat4 view_proj;
+} OcclusionTestJob;
+
+static void occlusion_test_job(void* ctx, int k) {
+    const OcclusionTestJob* job = ctx;
+    GameSceneData* d = job->d;
+    GameObject* go = d->objects[d->in_view[k]];
+    int visible = go->visible;
+    if (visible && d->occlusion && !go->occluder) {
+        Vec3 mn, mx;
+        object_bounds(go, &mn, &mx);
+        visible = occlusion_test_aabb(d->occlusion, job->view_proj, mn, mx);
+    }
+    d->unoccluded[k] = (unsigned char)visible;
+}
+
+static int compare_index(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
 static void game_scene_init(Scene* scene) {
     GameSceneData* d = scene->data;
 
-    d->ground_renderer = teapot_renderer_create(
+    d->ground_mesh = mesh_create(
         d->ground_vertices, d->ground_faces,
         d->ground_vcount, d->ground_fcount
     );
 
-    d->player_renderer = teapot_renderer_create(
+    d->player_mesh = mesh_create(
         d->player_vertices, d->player_faces,
         d->player_vcount, d->player_fcount
     );
 
     d->count = 4;
-    d->objects = calloc(d->count, sizeof(GameObject*));
+    d->objects = mem_calloc(d->count, sizeof(GameObject*), MEM_TAG_SCENE);
 
     d->player_pos = (Vec3){0, 0.5f, -4};
 
-    d->objects[0] = game_object_create_mesh(d->ground_renderer, mat4_identity());
-    d->objects[3] = game_object_create_mesh(
-        d->player_renderer,
+    d->objects[0] = d->ground_mesh ? game_object_create_mesh(d->ground_mesh, mat4_identity()) : NULL;
+    d->objects[3] = !d->player_mesh ? NULL : game_object_create_mesh(
+        d->player_mesh,
         mat4_translation(d->player_pos)
     );
 
@@ -87,7 +146,24 @@ static void game_scene_init(Scene* scene) {
         if (!d->objects[i]) continue;
         d->objects[i]->visible = 0;
     }
-    if (d->objects[3]) d->objects[3]->visible = 1;
+    if (d->objects[3]) {
+        d->objects[3]->visible = 1;
+        d->objects[3]->occluder = 1;
+    }
+
+    d->bvh = bvh_create();
+    d->proxies = mem_alloc(sizeof(int) * d->count, MEM_TAG_SCENE);
+    d->in_view = mem_alloc(sizeof(uint32_t) * d->count, MEM_TAG_SCENE);
+    d->unoccluded = mem_alloc(d->count, MEM_TAG_SCENE);
+    d->in_view_count = 0;
+    d->occlusion = occlusion_create(d->width, d->height, OCCLUSION_SCALE);
+    for (size_t i = 0; i < d->count; ++i) {
+        Vec3 mn, mx;
+        if (d->proxies) d->proxies[i] = -1;
+        if (!d->bvh || !d->proxies || !d->objects[i]) continue;
+        object_bounds(d->objects[i], &mn, &mx);
+        d->proxies[i] = bvh_insert(d->bvh, mn, mx, (uint32_t)i);
+    }
 
     d->player_index = 3;
     d->player_speed = 3.0f;
@@ -97,10 +173,12 @@ static void game_scene_init(Scene* scene) {
     d->rotation_speed = 8.0f;
 }
 
-static void game_scene_update(Scene* scene, float dt, Input* input, Camera* camera, Mat4 proj) {
+static void game_scene_update(Scene* scene, float dt, Input* input, Camera* camera, Mat4 proj, ClipDepth depth,
+                              Arena* frame) {
     GameSceneData* d = scene->data;
 
     d->proj = proj;
+    d->depth = depth;
     d->view = camera_get_view(camera);
     d->camera_pos = camera->position;
 
@@ -156,62 +234,75 @@ static void game_scene_update(Scene* scene, float dt, Input* input, Camera* came
     };
     camera->distance = 6.0f;
 
-    for (size_t i = 0; i < d->count; ++i) {
-        GameObject* go = d->objects[i];
-        if (!go || !go->visible) continue;
+    d->in_view_count = 0;
+    if (!d->bvh || !d->proxies || !d->in_view || !d->unoccluded) return;
+
+    // Only the player moves; small steps stay inside its fat box and change nothing.
+    if (d->proxies[d->player_index] >= 0) {
+        Vec3 mn, mx;
+        object_bounds(player, &mn, &mx);
+        bvh_move(d->bvh, d->proxies[d->player_index], mn, mx);
+    }
+
+    Mat4 view_proj = mat4_mul(d->proj, d->view);
+    Frustum frustum = frustum_from_matrix(view_proj, d->depth);
+    size_t hits = bvh_query_frustum(d->bvh, &frustum, d->in_view, d->count);
+    // Tree order is arbitrary; keep draws in object order so output doesn't depend on it.
+    qsort(d->in_view, hits, sizeof(uint32_t), compare_index);
+
+    if (d->occlusion) {
+        occlusion_clear(d->occlusion, d->depth);
+        for (size_t k = 0; k < hits; ++k) {
+            GameObject* go = d->objects[d->in_view[k]];
+            if (go->visible && go->occluder)
+                mesh_draw_occluder(go->mesh, go->model, view_proj, d->occlusion);
+        }
+    }
+
+    OcclusionTestJob test = { d, view_proj };
+    job_system_parallel_for(d->jobs, occlusion_test_job, &test, (int)hits, 16);
 
-        teapot_renderer_update(
+    // Every object's transformed vertices live in the frame arena.
+    for (size_t k = 0; k < hits; ++k) {
+        GameObject* go = d->objects[d->in_view[k]];
+        if (!d->unoccluded[k]) continue;
+
+        if (mesh_instance_update(
+            &go->instance,
             go->mesh,
             go->model,
             d->view,
             d->proj,
+            d->depth,
+            NULL,
             d->camera_pos,
             d->width,
-            d->height
-        );
+            d->height,
+            frame,
+            d->jobs
+        )) d->in_view[d->in_view_count++] = d->in_view[k];
+    }
+
+    if (d->occlusion) {
+        OcclusionStats stats = occlusion_stats(d->occlusion);
+        profiler_record_occlusion((int)stats.tested, (int)stats.culled);
     }
 }
 
-static void game_scene_render(Scene* scene, Renderer* r) {
+static void game_scene_render(Scene* scene, CommandBuffer* commands) {
     GameSceneData* d = scene->data;
 
-    int tiles_x = 20;
-    int tiles_z = 20;
-    float tile_size = 1.0f;
-    float half_w = (tiles_x * tile_size) * 0.5f;
-    float half_d = (tiles_z * tile_size) * 0.5f;
-
-    for (int iz = 0; iz < tiles_z; ++iz) {
-        for (int ix = 0; ix < tiles_x; ++ix) {
-            float x0 = ix * tile_size - half_w;
-            float z0 = iz * tile_size - half_d;
-            float x1 = x0 + tile_size;
-            float z1 = z0 + tile_size;
-
-            Vec3 w0 = {x0, 0.0f, z0};
-            Vec3 w1 = {x1, 0.0f, z0};
-            Vec3 w2 = {x1, 0.0f, z1};
-            Vec3 w3 = {x0, 0.0f, z1};
-
-            Vec3 s0, s1, s2, s3;
-            if (!geom_project_point(d->view, d->proj, w0, d->width, d->height, &s0, NULL)) continue;
-            if (!geom_project_point(d->view, d->proj, w1, d->width, d->height, &s1, NULL)) continue;
-            if (!geom_project_point(d->view, d->proj, w2, d->width, d->height, &s2, NULL)) continue;
-            if (!geom_project_point(d->view, d->proj, w3, d->width, d->height, &s3, NULL)) continue;
-
-            if (geom_triangle_backface_cull((Vec3[]){s0, s1, s2})) continue;
-
-            uint32_t color = ((ix + iz) & 1) ? 0xFF404040 : 0xFF202020;
-            renderer_draw_triangle(r, s0, s1, s2, color);
-            renderer_draw_triangle(r, s0, s2, s3, color);
-        }
-    }
+    ground_grid_record(commands, command_sort_key(LAYER_GROUND, 0.0f), d->view, d->proj, d->depth, d->width,
+                       d->height);
 
-    for (size_t i = 0; i < d->count; ++i) {
-        GameObject* go = d->objects[i];
-        if (!go || !go->visible) continue;
+    for (size_t k = 0; k < d->in_view_count; ++k) {
+        GameObject* go = d->objects[d->in_view[k]];
         if (go->type == GO_TYPE_MESH && go->mesh) {
-            teapot_renderer_draw(go->mesh, r, 0);
+            Vec3 c;
+            float radius;
+            mesh_world_sphere(go->mesh, go->model, &c, &radius);
+            float depth = vec3_length(vec3_sub(c, d->camera_pos));
+            mesh_instance_record(&go->instance, commands, command_sort_key(LAYER_OBJECTS, depth), 0);
         }
     }
 }
@@ -222,14 +313,19 @@ static void game_scene_destroy(Scene* scene) {
     for (size_t i = 0; i < d->count; ++i)
         if (d->objects[i]) game_object_destroy(d->objects[i]);
 
-    free(d->objects);
-    teapot_renderer_destroy(d->ground_renderer);
-    teapot_renderer_destroy(d->player_renderer);
-    free(d->ground_vertices);
-    free(d->ground_faces);
-    free(d->player_vertices);
-    free(d->player_faces);
-    free(d);
+    mem_free(d->objects);
+    bvh_destroy(d->bvh);
+    mem_free(d->proxies);
+    mem_free(d->in_view);
+    mem_free(d->unoccluded);
+    occlusion_destroy(d->occlusion);
+    mesh_destroy(d->ground_mesh);
+    mesh_destroy(d->player_mesh);
+    mem_free(d->ground_vertices);
+    mem_free(d->ground_faces);
+    mem_free(d->player_vertices);
+    mem_free(d->player_faces);
+    mem_free(d);
 }
 
 static SceneVTable vtable = {
@@ -245,16 +341,18 @@ Scene* game_scene_create(
     size_t vc,
     size_t fc,
     int w,
-    int h
+    int h,
+    JobSystem* jobs
 ) {
-    Scene* s = malloc(sizeof(Scene));
-    GameSceneData* d = calloc(1, sizeof(GameSceneData));
+    Scene* s = mem_alloc(sizeof(Scene), MEM_TAG_SCENE);
+    GameSceneData* d = mem_calloc(1, sizeof(GameSceneData), MEM_TAG_SCENE);
 
     d->width = w;
     d->height = h;
+    d->jobs = jobs;
 
-    d->player_vertices = malloc(sizeof(Vec3) * vc);
-    d->player_faces = malloc(sizeof(Face) * fc);
+    d->player_vertices = mem_alloc(sizeof(Vec3) * vc, MEM_TAG_SCENE);
+    d->player_faces = mem_alloc(sizeof(Face) * fc, MEM_TAG_SCENE);
     memcpy(d->player_vertices, verts, sizeof(Vec3) * vc);
     memcpy(d->player_faces, faces, sizeof(Face) * fc);
     d->player_vcount = vc;
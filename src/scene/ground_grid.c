@@ -0,0 +1,63 @@
+#include "ground_grid.h"
+
+#define GRID_TILES_X 20
+#define GRID_TILES_Z 20
+#define GRID_TILE_COUNT (GRID_TILES_X * GRID_TILES_Z)
+
+void ground_grid_record(CommandBuffer* cb, uint64_t key, Mat4 view, Mat4 proj, ClipDepth depth, int width, int height) {
+    float tile_size = 1.0f;
+    float half_w = (GRID_TILES_X * tile_size) * 0.5f;
+    float half_d = (GRID_TILES_Z * tile_size) * 0.5f;
+
+    // Four unshared corners per tile so every tile keeps its own flat colour. The streams
+    // live in the command buffer's arena until execute.
+    float* sx = command_buffer_alloc(cb, GRID_TILE_COUNT * 4 * sizeof(float), 32);
+    float* sy = command_buffer_alloc(cb, GRID_TILE_COUNT * 4 * sizeof(float), 32);
+    float* sz = command_buffer_alloc(cb, GRID_TILE_COUNT * 4 * sizeof(float), 32);
+    uint32_t* colors = command_buffer_alloc(cb, GRID_TILE_COUNT * 4 * sizeof(uint32_t), 32);
+    uint32_t* indices = command_buffer_alloc(cb, GRID_TILE_COUNT * 6 * sizeof(uint32_t), 32);
+    if (!sx || !sy || !sz || !colors || !indices) return;
+    size_t index_count = 0;
+
+    for (int iz = 0; iz < GRID_TILES_Z; ++iz) {
+        for (int ix = 0; ix < GRID_TILES_X; ++ix) {
+            float x0 = ix * tile_size - half_w;
+            float z0 = iz * tile_size - half_d;
+            float x1 = x0 + tile_size;
+            float z1 = z0 + tile_size;
+
+            Vec4 c[4];
+            Vec3 corners[4] = { {x0, 0.0f, z0}, {x1, 0.0f, z0}, {x1, 0.0f, z1}, {x0, 0.0f, z1} };
+            int inside = 1;
+            for (int k = 0; k < 4; ++k) {
+                Vec3 v = mat4_mul_vec3(view, corners[k]);
+                c[k] = mat4_mul_vec4(proj, (Vec4){v.x, v.y, v.z, 1.0f});
+                inside = inside && clip_vertex_inside(c[k], depth);
+            }
+
+            uint32_t color = ((ix + iz) & 1) ? 0xFF404040 : 0xFF202020;
+            if (!inside) {
+                // Crosses the near plane or leaves the guard band: clip it on its own.
+                command_buffer_draw_triangle_clip(cb, key, c[0], c[1], c[2], color, color, color);
+                command_buffer_draw_triangle_clip(cb, key, c[0], c[2], c[3], color, color, color);
+                continue;
+            }
+
+            uint32_t base = (uint32_t)(iz * GRID_TILES_X + ix) * 4;
+            for (int k = 0; k < 4; ++k) {
+                Vec3 s = clip_to_screen(c[k], width, height, depth);
+                sx[base + k] = s.x;
+                sy[base + k] = s.y;
+                sz[base + k] = s.z;
+                colors[base + k] = color;
+            }
+            uint32_t quad[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+            for (int k = 0; k < 6; ++k) indices[index_count++] = quad[k];
+        }
+    }
+
+    RendererDrawState state = {0};
+    state.flat = 1;
+    RendererVertexStreams positions = { sx, sy, sz };
+    command_buffer_draw_indexed(cb, key, positions, colors, indices, index_count, &state);
+}
@@ -0,0 +1,14 @@
+#ifndef GROUND_GRID_H
+#define GROUND_GRID_H
+
+#include <stdint.h>
+#include "core/mat.h"
+#include "core/clip.h"
+#include "renderer/command_buffer.h"
+
+// Records the 20x20 checkerboard ground of the game scene, centred on the origin at y = 0.
+// Tiles are clipped in clip space, so the ground stays whole when it passes under the camera.
+// `depth` is the clip-space convention of proj.
+void ground_grid_record(CommandBuffer* cb, uint64_t key, Mat4 view, Mat4 proj, ClipDepth depth, int width, int height);
+
+#endif // GROUND_GRID_H
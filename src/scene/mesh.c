@@ -0,0 +1,354 @@
+#include "mesh.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "core/geom.h"
+#include "core/math.h"
+#include "core/clip.h"
+#include "core/memory.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Smallest triangles drawn, in pixels, with the camera inside or outside the bounds.
+static const float MIN_AREA_INSIDE = 2.0f;
+static const float MIN_AREA_OUTSIDE = 4.0f;
+static const size_t MAX_PRIMITIVES = 20000;
+
+Mesh* mesh_create(const Vec3* vertices, const Face* faces, size_t vertex_count, size_t face_count) {
+    Mesh* m = mem_calloc(1, sizeof(Mesh), MEM_TAG_SCENE);
+    if (!m) return NULL;
+
+    m->faces = faces;
+    m->vertex_count = vertex_count;
+    m->face_count = face_count;
+    m->padded_count = (vertex_count + MESH_VERTEX_BATCH - 1) / MESH_VERTEX_BATCH * MESH_VERTEX_BATCH;
+
+    size_t n = m->padded_count ? m->padded_count : 1;
+    float** streams[] = { &m->pos_x, &m->pos_y, &m->pos_z, &m->nrm_x, &m->nrm_y, &m->nrm_z };
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(streams) / sizeof(streams[0]); ++i) {
+        *streams[i] = mem_calloc(n, sizeof(float), MEM_TAG_SCENE);
+        ok = ok && *streams[i];
+    }
+    m->indices = mem_alloc((face_count ? face_count : 1) * 3 * sizeof(uint32_t), MEM_TAG_SCENE);
+    Vec3* normals = mem_calloc(vertex_count ? vertex_count : 1, sizeof(Vec3), MEM_TAG_SCENE);
+    if (!ok || !m->indices || !normals) {
+        mem_free(normals);
+        mesh_destroy(m);
+        return NULL;
+    }
+
+    // compute center and bounding radius
+    if (vertex_count > 0) {
+        Vec3 sum = {0,0,0};
+        for (size_t i = 0; i < vertex_count; ++i) sum = vec3_add(sum, vertices[i]);
+        m->center = vec3_scale(sum, 1.0f / (float)vertex_count);
+        float maxd = 0.0f;
+        for (size_t i = 0; i < vertex_count; ++i) {
+            float d = vec3_length(vec3_sub(vertices[i], m->center));
+            if (d > maxd) maxd = d;
+        }
+        m->radius = maxd;
+    } else {
+        m->center = (Vec3){0,0,0};
+        m->radius = 1.0f;
+    }
+
+    // compute per-vertex normals by averaging face normals
+    for (size_t i = 0; i < face_count; ++i) {
+        Face f = faces[i];
+        if ((size_t)f.v1 >= vertex_count || (size_t)f.v2 >= vertex_count || (size_t)f.v3 >= vertex_count) continue;
+        Vec3 a = vertices[f.v1];
+        Vec3 b = vertices[f.v2];
+        Vec3 c = vertices[f.v3];
+        Vec3 fn = vec3_normalize(vec3_cross(vec3_sub(b,a), vec3_sub(c,a)));
+        normals[f.v1] = vec3_add(normals[f.v1], fn);
+        normals[f.v2] = vec3_add(normals[f.v2], fn);
+        normals[f.v3] = vec3_add(normals[f.v3], fn);
+
+        m->indices[m->index_count++] = (uint32_t)f.v1;
+        m->indices[m->index_count++] = (uint32_t)f.v2;
+        m->indices[m->index_count++] = (uint32_t)f.v3;
+    }
+
+    for (size_t i = 0; i < vertex_count; ++i) {
+        Vec3 nv = vec3_normalize(normals[i]);
+        m->pos_x[i] = vertices[i].x; m->pos_y[i] = vertices[i].y; m->pos_z[i] = vertices[i].z;
+        m->nrm_x[i] = nv.x;          m->nrm_y[i] = nv.y;          m->nrm_z[i] = nv.z;
+    }
+    mem_free(normals);
+
+    return m;
+}
+
+void mesh_destroy(Mesh* m) {
+    if (!m) return;
+    mem_free(m->pos_x); mem_free(m->pos_y); mem_free(m->pos_z);
+    mem_free(m->nrm_x); mem_free(m->nrm_y); mem_free(m->nrm_z);
+    mem_free(m->indices);
+    mem_free(m);
+}
+
+// Instance streams are 32-byte aligned so SIMD loads never split a cache line.
+#define STREAM_ALIGN 32
+
+size_t mesh_instance_scratch_size(const Mesh* m) {
+    size_t n = m->padded_count ? m->padded_count : 1;
+    return 3 * (n * sizeof(float) + STREAM_ALIGN)
+         + n * sizeof(unsigned char) + STREAM_ALIGN
+         + n * sizeof(uint32_t) + STREAM_ALIGN;
+}
+
+// Everything the vertex loop needs, fused once per object: mvp maps object space straight
+// to clip space, mv rows rotate normals (the lighting is evaluated in view space). The
+// NDC-to-screen scale and offset are folded in as well.
+typedef struct {
+    float mvp[4][4];
+    float mv[3][4];
+    float half_w, half_h;
+    ClipDepth depth;  // REVERSED: near plane at z = w, screen depth z / w
+    Vec3 light;
+    float ambient;
+} VertexTransform;
+
+#if !defined(__AVX2__)
+static void transform_vertices_scalar(const Mesh* m, MeshInstance* t, const VertexTransform* x,
+                                      size_t begin, size_t end) {
+    if (end > m->vertex_count) end = m->vertex_count;
+    for (size_t i = begin; i < end; ++i) {
+        float px = m->pos_x[i], py = m->pos_y[i], pz = m->pos_z[i];
+        float cx = x->mvp[0][0]*px + x->mvp[0][1]*py + x->mvp[0][2]*pz + x->mvp[0][3];
+        float cy = x->mvp[1][0]*px + x->mvp[1][1]*py + x->mvp[1][2]*pz + x->mvp[1][3];
+        float cz = x->mvp[2][0]*px + x->mvp[2][1]*py + x->mvp[2][2]*pz + x->mvp[2][3];
+        float cw = x->mvp[3][0]*px + x->mvp[3][1]*py + x->mvp[3][2]*pz + x->mvp[3][3];
+        // Vertices needing clipping keep their colour; draw re-derives their clip position.
+        t->valid[i] = (unsigned char)(cw > 1e-6f && clip_vertex_inside((Vec4){cx, cy, cz, cw}, x->depth));
+        if (t->valid[i]) {
+            float inv_w = 1.0f / cw;
+            t->screen_x[i] = (cx * inv_w + 1.0f) * x->half_w;
+            t->screen_y[i] = (1.0f - cy * inv_w) * x->half_h;
+            t->screen_z[i] = x->depth == CLIP_DEPTH_REVERSED ? cz * inv_w : (cz * inv_w + 1.0f) * 0.5f;
+        } else {
+            t->screen_x[i] = t->screen_y[i] = t->screen_z[i] = INFINITY;
+        }
+
+        float nx = m->nrm_x[i], ny = m->nrm_y[i], nz = m->nrm_z[i];
+        float vx = x->mv[0][0]*nx + x->mv[0][1]*ny + x->mv[0][2]*nz;
+        float vy = x->mv[1][0]*nx + x->mv[1][1]*ny + x->mv[1][2]*nz;
+        float vz = x->mv[2][0]*nx + x->mv[2][1]*ny + x->mv[2][2]*nz;
+        float len = sqrtf(vx*vx + vy*vy + vz*vz);
+        float inv_len = len > 0.0f ? 1.0f / len : 0.0f;
+        float diff = fmaxf((vx*x->light.x + vy*x->light.y + vz*x->light.z) * inv_len, 0.0f);
+        float intensity = x->ambient + diff*(1.0f - x->ambient);
+        uint32_t c = (uint32_t)clampf(intensity*255.0f, 0.0f, 255.0f);
+        t->colors[i] = 0xFF000000 | (c<<16) | (c<<8) | c;
+    }
+}
+
+#else
+static inline __m256 row_dot(const float row[4], __m256 x, __m256 y, __m256 z, int affine) {
+    __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(row[0]), x),
+                                           _mm256_mul_ps(_mm256_set1_ps(row[1]), y)),
+                             _mm256_mul_ps(_mm256_set1_ps(row[2]), z));
+    return affine ? _mm256_add_ps(r, _mm256_set1_ps(row[3])) : r;
+}
+
+// Same arithmetic as the scalar path, eight vertices per iteration over the padded
+// streams. Padding lanes transform harmlessly and are never referenced by faces.
+static void transform_vertices_avx2(const Mesh* m, MeshInstance* t, const VertexTransform* x,
+                                    size_t begin, size_t end) {
+    const __m256 one = _mm256_set1_ps(1.0f), half = _mm256_set1_ps(0.5f), zero = _mm256_setzero_ps();
+    const __m256 half_w = _mm256_set1_ps(x->half_w), half_h = _mm256_set1_ps(x->half_h);
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+
+    for (size_t i = begin; i < end; i += MESH_VERTEX_BATCH) {
+        __m256 px = _mm256_loadu_ps(&m->pos_x[i]);
+        __m256 py = _mm256_loadu_ps(&m->pos_y[i]);
+        __m256 pz = _mm256_loadu_ps(&m->pos_z[i]);
+        __m256 cx = row_dot(x->mvp[0], px, py, pz, 1);
+        __m256 cy = row_dot(x->mvp[1], px, py, pz, 1);
+        __m256 cz = row_dot(x->mvp[2], px, py, pz, 1);
+        __m256 cw = row_dot(x->mvp[3], px, py, pz, 1);
+        // Same test as clip_vertex_inside: in front of the near plane, inside the guard band.
+        __m256 gw = _mm256_mul_ps(cw, _mm256_set1_ps(CLIP_GUARD_BAND));
+        __m256 ngw = _mm256_sub_ps(zero, gw);
+        __m256 valid = _mm256_cmp_ps(cw, _mm256_set1_ps(1e-6f), _CMP_GT_OQ);
+        if (x->depth == CLIP_DEPTH_REVERSED) valid = _mm256_and_ps(valid, _mm256_cmp_ps(cz, cw, _CMP_LE_OQ));
+        else valid = _mm256_and_ps(valid, _mm256_cmp_ps(cz, _mm256_sub_ps(zero, cw), _CMP_GE_OQ));
+        valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(cx, gw, _CMP_LE_OQ), _mm256_cmp_ps(cx, ngw, _CMP_GE_OQ)));
+        valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(cy, gw, _CMP_LE_OQ), _mm256_cmp_ps(cy, ngw, _CMP_GE_OQ)));
+
+        __m256 inv_w = _mm256_div_ps(one, cw);
+        __m256 sx = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(cx, inv_w), one), half_w);
+        __m256 sy = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(cy, inv_w)), half_h);
+        __m256 sz = _mm256_mul_ps(cz, inv_w);
+        if (x->depth == CLIP_DEPTH_STANDARD) sz = _mm256_mul_ps(_mm256_add_ps(sz, one), half);
+        _mm256_storeu_ps(&t->screen_x[i], _mm256_blendv_ps(inf, sx, valid));
+        _mm256_storeu_ps(&t->screen_y[i], _mm256_blendv_ps(inf, sy, valid));
+        _mm256_storeu_ps(&t->screen_z[i], _mm256_blendv_ps(inf, sz, valid));
+
+        __m256 nx = _mm256_loadu_ps(&m->nrm_x[i]);
+        __m256 ny = _mm256_loadu_ps(&m->nrm_y[i]);
+        __m256 nz = _mm256_loadu_ps(&m->nrm_z[i]);
+        __m256 vx = row_dot(x->mv[0], nx, ny, nz, 0);
+        __m256 vy = row_dot(x->mv[1], nx, ny, nz, 0);
+        __m256 vz = row_dot(x->mv[2], nx, ny, nz, 0);
+        __m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)),
+                                                  _mm256_mul_ps(vz, vz)));
+        __m256 inv_len = _mm256_and_ps(_mm256_div_ps(one, len), _mm256_cmp_ps(len, zero, _CMP_GT_OQ));
+        __m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, _mm256_set1_ps(x->light.x)),
+                                                 _mm256_mul_ps(vy, _mm256_set1_ps(x->light.y))),
+                                   _mm256_mul_ps(vz, _mm256_set1_ps(x->light.z)));
+        __m256 diff = _mm256_max_ps(_mm256_mul_ps(dot, inv_len), zero);
+        __m256 intensity = _mm256_add_ps(_mm256_set1_ps(x->ambient),
+                                         _mm256_mul_ps(diff, _mm256_set1_ps(1.0f - x->ambient)));
+        __m256 level = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(intensity, _mm256_set1_ps(255.0f)), zero),
+                                     _mm256_set1_ps(255.0f));
+        __m256i c = _mm256_cvttps_epi32(level);
+        c = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(c, 16), _mm256_slli_epi32(c, 8)), c);
+        c = _mm256_or_si256(c, _mm256_set1_epi32((int)0xFF000000));
+        _mm256_storeu_si256((__m256i*)&t->colors[i], c);
+
+        // Validity bytes: one movemask bit per lane.
+        int bits = _mm256_movemask_ps(valid);
+        for (int k = 0; k < MESH_VERTEX_BATCH; ++k) t->valid[i + k] = (unsigned char)((bits >> k) & 1);
+    }
+}
+#endif
+
+// Vertices per transform job; a multiple of MESH_VERTEX_BATCH. Small meshes stay one job.
+#define TRANSFORM_CHUNK 2048
+
+typedef struct {
+    const Mesh* mesh;
+    MeshInstance* inst;
+    const VertexTransform* x;
+} TransformJob;
+
+static void transform_chunk(void* ctx, int chunk) {
+    const TransformJob* job = ctx;
+    size_t begin = (size_t)chunk * TRANSFORM_CHUNK;
+    size_t end = begin + TRANSFORM_CHUNK;
+    if (end > job->mesh->padded_count) end = job->mesh->padded_count;
+#if defined(__AVX2__)
+    transform_vertices_avx2(job->mesh, job->inst, job->x, begin, end);
+#else
+    transform_vertices_scalar(job->mesh, job->inst, job->x, begin, end);
+#endif
+}
+
+void mesh_world_sphere(const Mesh* mesh, Mat4 model, Vec3* center, float* radius) {
+    float scale = 0.0f;
+    for (int c = 0; c < 3; ++c) {
+        float len = vec3_length((Vec3){model.m[0][c], model.m[1][c], model.m[2][c]});
+        if (len > scale) scale = len;
+    }
+    *center = geom_transform_point(model, mesh->center);
+    *radius = mesh->radius * scale;
+}
+
+int mesh_instance_update(MeshInstance* inst, const Mesh* mesh, Mat4 model, Mat4 view, Mat4 proj,
+                         ClipDepth depth, const Frustum* frustum, Vec3 camera_pos, int width, int height, Arena* scratch,
+                         JobSystem* jobs) {
+    inst->mesh = mesh;
+    inst->visible = 0;
+
+    Vec3 world_center;
+    float world_radius;
+    mesh_world_sphere(mesh, model, &world_center, &world_radius);
+    if (frustum && !frustum_test_sphere(frustum, world_center, world_radius))
+        return 0;
+
+    size_t n = mesh->padded_count ? mesh->padded_count : 1;
+    inst->screen_x = arena_alloc_aligned(scratch, n * sizeof(float), STREAM_ALIGN);
+    inst->screen_y = arena_alloc_aligned(scratch, n * sizeof(float), STREAM_ALIGN);
+    inst->screen_z = arena_alloc_aligned(scratch, n * sizeof(float), STREAM_ALIGN);
+    inst->valid    = arena_alloc_aligned(scratch, n * sizeof(unsigned char), STREAM_ALIGN);
+    inst->colors   = arena_alloc_aligned(scratch, n * sizeof(uint32_t), STREAM_ALIGN);
+    if (!inst->screen_x || !inst->screen_y || !inst->screen_z || !inst->valid || !inst->colors)
+        return 0;
+
+    Mat4 view_model = mat4_mul(view, model);
+    Mat4 mvp = mat4_mul(proj, view_model);
+    VertexTransform x;
+    memcpy(x.mvp, mvp.m, sizeof(x.mvp));
+    memcpy(x.mv, view_model.m, sizeof(x.mv));
+    x.half_w = 0.5f * (float)width;
+    x.half_h = 0.5f * (float)height;
+    x.depth = depth;
+    // light direction: from above and at an angle
+    Vec3 light_pos = vec3_add(world_center, (Vec3){2.0f, 5.0f, 3.0f});
+    x.light = vec3_normalize(vec3_sub(light_pos, world_center));
+    x.ambient = 0.15f;
+
+    TransformJob job = { mesh, inst, &x };
+    int chunks = (int)((mesh->padded_count + TRANSFORM_CHUNK - 1) / TRANSFORM_CHUNK);
+    job_system_parallel_for(jobs, transform_chunk, &job, chunks, 1);
+
+    inst->mvp = mvp;
+    inst->depth = depth;
+    inst->width = width;
+    inst->height = height;
+    inst->inside = (vec3_length(vec3_sub(camera_pos, world_center)) < world_radius);
+    inst->visible = 1;
+    return 1;
+}
+
+void mesh_draw_occluder(const Mesh* mesh, Mat4 model, Mat4 view_proj, OcclusionBuffer* ob) {
+    Mat4 mvp = mat4_mul(view_proj, model);
+    for (size_t i = 0; i < mesh->index_count; i += 3) {
+        Vec4 c[3];
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = mesh->indices[i + k];
+            c[k] = mat4_mul_vec4(mvp, (Vec4){mesh->pos_x[v], mesh->pos_y[v], mesh->pos_z[v], 1.0f});
+        }
+        occlusion_draw_triangle(ob, c[0], c[1], c[2]);
+    }
+}
+
+// Slow path for triangles with a vertex behind the near plane or outside the guard band:
+// their clip positions are rebuilt from the mesh and clipped at execute time.
+static void record_clipped(const MeshInstance* t, CommandBuffer* cb, uint64_t key, const uint32_t idxs[3],
+                           int wireframe_pref) {
+    const Mesh* m = t->mesh;
+    ClipVertex in[3];
+    for (int k = 0; k < 3; ++k) {
+        uint32_t v = idxs[k];
+        in[k].pos = mat4_mul_vec4(t->mvp, (Vec4){m->pos_x[v], m->pos_y[v], m->pos_z[v], 1.0f});
+        in[k].color = t->colors[v];
+    }
+
+    if (!wireframe_pref) {
+        command_buffer_draw_triangle_clip(cb, key, in[0].pos, in[1].pos, in[2].pos,
+                                          in[0].color, in[1].color, in[2].color);
+        return;
+    }
+
+    ClipVertex poly[CLIP_MAX_VERTICES];
+    int n = clip_triangle(in, poly, t->depth);
+    for (int i = 0; i < n; ++i) {
+        Vec3 a = clip_to_screen(poly[i].pos, t->width, t->height, t->depth);
+        Vec3 b = clip_to_screen(poly[(i + 1) % n].pos, t->width, t->height, t->depth);
+        command_buffer_draw_line(cb, key, a, b, 0xFFFFFFFF);
+    }
+}
+
+void mesh_instance_record(const MeshInstance* t, CommandBuffer* cb, uint64_t key, int wireframe_pref) {
+    if (!t->visible) return;
+    const Mesh* m = t->mesh;
+
+    RendererDrawState state = {0};
+    state.min_area = t->inside ? MIN_AREA_INSIDE : MIN_AREA_OUTSIDE;
+    state.max_triangles = wireframe_pref ? MAX_PRIMITIVES / 3 : MAX_PRIMITIVES;
+    state.wireframe = wireframe_pref;
+    RendererVertexStreams positions = { t->screen_x, t->screen_y, t->screen_z };
+    command_buffer_draw_indexed(cb, key, positions, t->colors, m->indices, m->index_count, &state);
+
+    // The batch skips every triangle with a vertex that needs clipping.
+    for (size_t i = 0; i < m->index_count; i += 3) {
+        const uint32_t* idxs = &m->indices[i];
+        if (t->valid[idxs[0]] && t->valid[idxs[1]] && t->valid[idxs[2]]) continue;
+        record_clipped(t, cb, key, idxs, wireframe_pref);
+    }
+}
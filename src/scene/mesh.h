@@ -0,0 +1,80 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core/vec.h"
+#include "core/mat.h"
+#include "core/arena.h"
+#include "core/culling.h"
+#include "core/occlusion.h"
+#include "core/job_system.h"
+#include "assets/objloader.h"
+#include "renderer/renderer.h"
+#include "renderer/command_buffer.h"
+
+// Vertex streams are padded to a multiple of this so transforms run whole SIMD batches.
+#define MESH_VERTEX_BATCH 8
+
+// Immutable geometry, shared by any number of instances. Positions and unit normals are
+// structure-of-arrays streams padded to MESH_VERTEX_BATCH. Faces are borrowed: they must
+// outlive the mesh. indices holds the in-range faces as a flat triangle list.
+typedef struct {
+    const Face* faces;
+    size_t vertex_count;
+    size_t face_count;
+    size_t padded_count;
+
+    uint32_t* indices;
+    size_t index_count;
+
+    float *pos_x, *pos_y, *pos_z;
+    float *nrm_x, *nrm_y, *nrm_z;
+
+    Vec3 center;
+    float radius;
+} Mesh;
+
+Mesh* mesh_create(const Vec3* vertices, const Face* faces, size_t vertex_count, size_t face_count);
+void mesh_destroy(Mesh* mesh);
+
+// One placement of a mesh for one frame: the lightweight per-draw record. Its transformed
+// streams (screen position, validity, lit colour) are carved from the scratch arena given
+// to mesh_instance_update and stay valid until that arena is reset. A vertex is valid when
+// it projects without clipping; triangles touching an invalid vertex are clipped at draw
+// time from the mesh positions and mvp.
+typedef struct {
+    const Mesh* mesh;
+    float *screen_x, *screen_y, *screen_z;
+    unsigned char* valid;
+    uint32_t* colors;
+    Mat4 mvp;
+    ClipDepth depth;  // convention of mvp's clip space
+    int width, height;
+    int visible;  // passed the frustum test at the last update; record is a no-op otherwise
+    int inside;   // camera was inside the bounding sphere
+} MeshInstance;
+
+// World-space bounding sphere of the mesh placed with `model` (radius grows with scale).
+void mesh_world_sphere(const Mesh* mesh, Mat4 model, Vec3* center, float* radius);
+
+// Scratch bytes one mesh_instance_update of `mesh` takes, alignment padding included.
+size_t mesh_instance_scratch_size(const Mesh* mesh);
+
+// Transforms, projects and lights the mesh for this instance; `depth` is the clip-space
+// convention of proj. The bounding sphere is tested against `frustum` first; pass NULL if
+// the caller already culled it. Returns 1 if it is visible, 0 if it was culled or the
+// scratch arena ran out. Large meshes are transformed in vertex chunks on `jobs` (NULL: on
+// the caller).
+int mesh_instance_update(MeshInstance* inst, const Mesh* mesh, Mat4 model, Mat4 view, Mat4 proj,
+                         ClipDepth depth, const Frustum* frustum, Vec3 camera_pos,
+                         int width, int height, Arena* scratch, JobSystem* jobs);
+// Records the instance's draws under `key`, referencing the streams mesh_instance_update
+// produced rather than deferring the transform. Those streams must outlive the command
+// buffer's execute, so reset the scratch arena only after that.
+void mesh_instance_record(const MeshInstance* inst, CommandBuffer* cb, uint64_t key, int wireframe_pref);
+
+// Rasterizes every face of the mesh placed with `model` into the occlusion buffer.
+void mesh_draw_occluder(const Mesh* mesh, Mat4 model, Mat4 view_proj, OcclusionBuffer* ob);
+
+#endif // MESH_H
@@ -1,12 +1,13 @@
 #include "scene.h"
 #include <stdlib.h>
+#include "core/memory.h"
 
 static Scene* current_scene = NULL;
 
 void scene_manager_set(Scene* scene) {
     if (current_scene && current_scene->vtable && current_scene->vtable->destroy) {
         current_scene->vtable->destroy(current_scene);
-        free(current_scene);
+        mem_free(current_scene);
     }
     current_scene = scene;
     if (current_scene && current_scene->vtable && current_scene->vtable->init) {
@@ -14,22 +15,22 @@ void scene_manager_set(Scene* scene) {
     }
 }
 
-void scene_manager_update(float delta_time, Input* input, Camera* camera, Mat4 proj) {
+void scene_manager_update(float delta_time, Input* input, Camera* camera, Mat4 proj, ClipDepth depth, Arena* frame) {
     if (current_scene && current_scene->vtable && current_scene->vtable->update) {
-        current_scene->vtable->update(current_scene, delta_time, input, camera, proj);
+        current_scene->vtable->update(current_scene, delta_time, input, camera, proj, depth, frame);
     }
 }
 
-void scene_manager_render(Renderer* renderer) {
+void scene_manager_render(CommandBuffer* commands) {
     if (current_scene && current_scene->vtable && current_scene->vtable->render) {
-        current_scene->vtable->render(current_scene, renderer);
+        current_scene->vtable->render(current_scene, commands);
     }
 }
 
 void scene_manager_destroy() {
     if (current_scene && current_scene->vtable && current_scene->vtable->destroy) {
         current_scene->vtable->destroy(current_scene);
-        free(current_scene);
+        mem_free(current_scene);
     }
     current_scene = NULL;
 }
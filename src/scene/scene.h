@@ -1,17 +1,24 @@
 #ifndef SCENE_H
 #define SCENE_H
 
-#include "renderer/renderer.h"
+#include "renderer/command_buffer.h"
 #include "platform/input.h"
 #include "core/camera.h"
 #include "core/mat.h"
+#include "core/clip.h"
+#include "core/arena.h"
 
 typedef struct Scene Scene;
 
 typedef struct SceneVTable {
     void (*init)(Scene* scene);
-    void (*update)(Scene* scene, float delta_time, Input* input, Camera* camera, Mat4 proj);
-    void (*render)(Scene* scene, Renderer* renderer);
+    // Per-frame data goes in `frame`: the caller resets it only once the frame recorded
+    // from this update has been rasterized. `depth` is the clip-space convention of proj,
+    // the target renderer's.
+    void (*update)(Scene* scene, float delta_time, Input* input, Camera* camera, Mat4 proj, ClipDepth depth,
+                   Arena* frame);
+    // Records the frame's draws; the caller executes the buffer into the renderer.
+    void (*render)(Scene* scene, CommandBuffer* commands);
     void (*destroy)(Scene* scene);
 } SceneVTable;
 
@@ -22,8 +29,8 @@ struct Scene {
 
 // Scene manager API
 void scene_manager_set(Scene* scene);
-void scene_manager_update(float delta_time, Input* input, Camera* camera, Mat4 proj);
-void scene_manager_render(Renderer* renderer);
+void scene_manager_update(float delta_time, Input* input, Camera* camera, Mat4 proj, ClipDepth depth, Arena* frame);
+void scene_manager_render(CommandBuffer* commands);
 void scene_manager_destroy();
 
 #endif // SCENE_H
@@ -4,8 +4,9 @@
 #include "scene.h"
 #include "core/vec.h"
 #include "assets/objloader.h"
+#include "core/job_system.h"
 
-Scene* scene_factory_create_start_scene(const Vec3* vertices, const Face* faces, size_t vcount, size_t fcount, int width, int height);
-Scene* scene_factory_create_game_scene(const Vec3* vertices, const Face* faces, size_t vcount, size_t fcount, int width, int height);
+Scene* scene_factory_create_start_scene(const Vec3* vertices, const Face* faces, size_t vcount, size_t fcount, int width, int height, JobSystem* jobs);
+Scene* scene_factory_create_game_scene(const Vec3* vertices, const Face* faces, size_t vcount, size_t fcount, int width, int height, JobSystem* jobs);
 
 #endif // SCENE_FACTORY_H
@@ -4,14 +4,22 @@
 #include "core/vec.h"
 #include "assets/objloader.h"
 #include "core/mat.h"
-#include "renderer/renderer.h"
+#include "core/clip.h"
+#include "renderer/command_buffer.h"
+#include "core/job_system.h"
+#include "core/arena.h"
 
 typedef struct TeapotRenderer TeapotRenderer;
 
 TeapotRenderer* teapot_renderer_create(const Vec3* vertices, const Face* faces, size_t vertex_count, size_t face_count);
 void teapot_renderer_destroy(TeapotRenderer* t);
 
-int teapot_renderer_update(TeapotRenderer* t, Mat4 model, Mat4 view, Mat4 proj, Vec3 camera_pos, int width, int height);
-void teapot_renderer_draw(TeapotRenderer* t, Renderer* r, int wireframe_pref);
+// Transformed vertices go in `frame` if given (it must outlive the recorded frame), else in
+// the renderer's own pair of scratch arenas. `depth` is the clip-space convention of proj.
+int teapot_renderer_update(TeapotRenderer* t, Mat4 model, Mat4 view, Mat4 proj, ClipDepth depth, Vec3 camera_pos,
+                           int width, int height, Arena* frame);
+// Transforms on `jobs` from the next update on; not owned. NULL (the default) runs on the caller.
+void teapot_renderer_set_job_system(TeapotRenderer* t, JobSystem* jobs);
+void teapot_renderer_record(TeapotRenderer* t, CommandBuffer* cb, uint64_t key, int wireframe_pref);
 
 #endif // TEAPOT_RENDERER_H
@@ -2,6 +2,7 @@
 #include "scene/teapot_renderer.h"
 #include <stdlib.h>
 #include <string.h>
+#include "core/memory.h"
 
 typedef struct {
     TeapotRenderer* teapot;
@@ -12,16 +13,20 @@ typedef struct {
     int wireframe;
     float angle;
     Mat4 model, view, proj;
+    ClipDepth depth;
     Vec3 camera_pos;
     int width, height;
+    JobSystem* jobs;
 } TeapotSceneData;
 
 static void teapot_scene_init(Scene* scene) {
     TeapotSceneData* data = (TeapotSceneData*)scene->data;
     data->teapot = teapot_renderer_create(data->vertices, data->faces, data->vertex_count, data->face_count);
+    teapot_renderer_set_job_system(data->teapot, data->jobs);
 }
 
-static void teapot_scene_update(Scene* scene, float delta_time, Input* input, Camera* camera, Mat4 proj) {
+static void teapot_scene_update(Scene* scene, float delta_time, Input* input, Camera* camera, Mat4 proj,
+                                ClipDepth depth, Arena* frame) {
     TeapotSceneData* data = (TeapotSceneData*)scene->data;
     if (input->keyboard.pressed[SDL_SCANCODE_TAB]) {
         data->wireframe = !data->wireframe;
@@ -35,23 +40,25 @@ static void teapot_scene_update(Scene* scene, float delta_time, Input* input, Ca
     Mat4 model = mat4_mul(translation, rotation);
 
     data->proj = proj;
+    data->depth = depth;
     data->view = camera_get_view(camera);
     data->camera_pos = camera->position;
 
-    teapot_renderer_update(data->teapot, model, data->view, data->proj, data->camera_pos, data->width, data->height);
+    teapot_renderer_update(data->teapot, model, data->view, data->proj, data->depth, data->camera_pos, data->width,
+                           data->height, frame);
 }
 
-static void teapot_scene_render(Scene* scene, Renderer* renderer) {
+static void teapot_scene_render(Scene* scene, CommandBuffer* commands) {
     TeapotSceneData* data = (TeapotSceneData*)scene->data;
-    teapot_renderer_draw(data->teapot, renderer, data->wireframe);
+    teapot_renderer_record(data->teapot, commands, command_sort_key(0, 0.0f), data->wireframe);
 }
 
 static void teapot_scene_destroy(Scene* scene) {
     TeapotSceneData* data = (TeapotSceneData*)scene->data;
     if (data->teapot) teapot_renderer_destroy(data->teapot);
-    free(data->vertices);
-    free(data->faces);
-    free(data);
+    mem_free(data->vertices);
+    mem_free(data->faces);
+    mem_free(data);
     scene->data = NULL;
 }
 
@@ -62,22 +69,24 @@ static SceneVTable teapot_scene_vtable = {
     .destroy = teapot_scene_destroy
 };
 
-Scene* teapot_scene_create(const Vec3* vertices, const Face* faces, size_t vertex_count, size_t face_count, int width, int height) {
-    Scene* scene = malloc(sizeof(Scene));
-    TeapotSceneData* data = malloc(sizeof(TeapotSceneData));
-    data->vertices = malloc(sizeof(Vec3) * vertex_count);
+Scene* teapot_scene_create(const Vec3* vertices, const Face* faces, size_t vertex_count, size_t face_count, int width, int height, JobSystem* jobs) {
+    Scene* scene = mem_alloc(sizeof(Scene), MEM_TAG_SCENE);
+    TeapotSceneData* data = mem_alloc(sizeof(TeapotSceneData), MEM_TAG_SCENE);
+    data->vertices = mem_alloc(sizeof(Vec3) * vertex_count, MEM_TAG_SCENE);
     memcpy(data->vertices, vertices, sizeof(Vec3) * vertex_count);
-    data->faces = malloc(sizeof(Face) * face_count);
+    data->faces = mem_alloc(sizeof(Face) * face_count, MEM_TAG_SCENE);
     memcpy(data->faces, faces, sizeof(Face) * face_count);
     data->vertex_count = vertex_count;
     data->face_count = face_count;
     data->wireframe = 0;
     data->angle = 0.0f;
     data->proj = mat4_identity();
+    data->depth = CLIP_DEPTH_STANDARD;
     data->view = mat4_identity();
     data->camera_pos = (Vec3){0,0,0};
     data->width = width;
     data->height = height;
+    data->jobs = jobs;
     scene->data = data;
     scene->vtable = &teapot_scene_vtable;
     return scene;
@@ -4,7 +4,8 @@
 #include "scene/scene.h"
 #include "core/vec.h"
 #include "assets/objloader.h"
+#include "core/job_system.h"
 
-Scene* teapot_scene_create(const Vec3* vertices, const Face* faces, size_t vertex_count, size_t face_count, int width, int height);
+Scene* teapot_scene_create(const Vec3* vertices, const Face* faces, size_t vertex_count, size_t face_count, int width, int height, JobSystem* jobs);
 
 #endif // TEAPOT_SCENE_H